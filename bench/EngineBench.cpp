@@ -0,0 +1,542 @@
+// Fixed workloads over the engine's hot paths: model import (car.blend and generated meshes),
+// texture decode, mesh cooking, culling over many objects and draw submission. Every benchmark
+// reports the median and best of several runs as JSON; a median above its threshold in
+// thresholds.txt is a regression and makes the process exit with 1.
+//
+//   engine_bench [--root DIR] [--json FILE] [--thresholds FILE] [--filter TEXT]
+//                [--update-thresholds]
+//
+// Import and draw benchmarks need a GL context. Headless machines can use Mesa's llvmpipe,
+// e.g. `LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a engine_bench`; without a context they are skipped.
+// --update-thresholds rewrites the thresholds file from this run with THRESHOLD_MARGIN of
+// headroom, run it on the reference machine after an intended performance change.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "CommandReplayer.h"
+#include "CascadedShadowMap.h"
+#include "Culling.h"
+#include "FrameSnapshot.h"
+#include "JobSystem.h"
+#include "LightManager.h"
+#include "Model.h"
+#include "PassRecorder.h"
+#include "Path.h"
+#include "SceneSystems.h"
+#include "Shader.h"
+#include "TextureArray.h"
+#include "VirtualFileSystem.h"
+#include "World.h"
+
+#ifndef MOFU_SOURCE_ROOT
+#define MOFU_SOURCE_ROOT ".."
+#endif
+#ifndef MOFU_DEFAULT_THRESHOLDS
+#define MOFU_DEFAULT_THRESHOLDS "thresholds.txt"
+#endif
+
+namespace {
+
+constexpr double THRESHOLD_MARGIN = 1.5;
+constexpr int GRID_SIZE = 384;
+constexpr size_t CULL_OBJECT_NUM = 100000;
+constexpr size_t OCCLUSION_QUERY_NUM = 20000;
+constexpr int DRAW_INSTANCE_NUM = 64;
+constexpr int WINDOW_WIDTH = 640;
+constexpr int WINDOW_HEIGHT = 480;
+constexpr unsigned int RANDOM_SEED = 20240601;
+
+struct BenchResult {
+    std::string name;
+    int iterations = 0;
+    double median_ms = 0.0;
+    double min_ms = 0.0;
+    bool skipped = false;
+    // the warm-up run left a GL error, the timings would not mean anything
+    bool gl_error = false;
+};
+
+struct BenchContext {
+    std::string root;
+    std::string filter;
+    bool has_gl = false;
+    std::vector<BenchResult> results = {};
+};
+
+double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+bool Selected(const BenchContext& context, const std::string& name) {
+    return context.filter.empty() || name.find(context.filter) != std::string::npos;
+}
+
+// one untimed warm-up run, then the median of the timed ones. GL benchmarks fail when the
+// warm-up raises a GL error.
+void Measure(BenchContext& context, const std::string& name, int iterations, bool needs_gl,
+    const std::function<void()>& run) {
+    if (!Selected(context, name)) {
+        return;
+    }
+    BenchResult result;
+    result.name = name;
+    if (needs_gl && !context.has_gl) {
+        result.skipped = true;
+        context.results.push_back(result);
+        std::cerr << name << ": skipped, no GL context" << std::endl;
+        return;
+    }
+    if (needs_gl) {
+        while (glGetError() != GL_NO_ERROR) {
+        }
+    }
+    run();
+    GLenum error = needs_gl ? glGetError() : GL_NO_ERROR;
+    if (error != GL_NO_ERROR) {
+        result.gl_error = true;
+        context.results.push_back(result);
+        std::cerr << name << ": failed, GL error 0x" << std::hex << error << std::dec <<
+            std::endl;
+        return;
+    }
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        times.push_back(Milliseconds(start));
+    }
+    std::sort(times.begin(), times.end());
+    result.iterations = iterations;
+    result.median_ms = times[times.size() / 2];
+    result.min_ms = times.front();
+    context.results.push_back(result);
+    std::cerr << name << ": " << result.median_ms << " ms" << std::endl;
+}
+
+// a wavy GRID_SIZE x GRID_SIZE vertex sheet as Wavefront OBJ text
+std::string GenerateGridObj() {
+    std::string obj;
+    obj.reserve(static_cast<size_t>(GRID_SIZE) * GRID_SIZE * 64);
+    char line[128];
+    for (int z = 0; z < GRID_SIZE; z++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            float height = 0.25f * std::sin(x * 0.1f) * std::cos(z * 0.1f);
+            std::snprintf(line, sizeof(line), "v %.4f %.4f %.4f\nvt %.4f %.4f\n",
+                x * 0.1f, height, z * 0.1f, static_cast<float>(x) / (GRID_SIZE - 1),
+                static_cast<float>(z) / (GRID_SIZE - 1));
+            obj += line;
+        }
+    }
+    for (int z = 0; z + 1 < GRID_SIZE; z++) {
+        for (int x = 0; x + 1 < GRID_SIZE; x++) {
+            int a = z * GRID_SIZE + x + 1;
+            int b = a + 1;
+            int c = a + GRID_SIZE;
+            int d = c + 1;
+            std::snprintf(line, sizeof(line), "f %d/%d %d/%d %d/%d %d/%d\n", a, a, c, c, d, d,
+                b, b);
+            obj += line;
+        }
+    }
+    return obj;
+}
+
+bool CreateContext(GLFWwindow*& window) {
+    if (!glfwInit()) {
+        return false;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "MofuBench", nullptr, nullptr);
+    if (window == nullptr) {
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        return false;
+    }
+    std::cerr << "GL renderer: " << glGetString(GL_RENDERER) << std::endl;
+    return true;
+}
+
+void RunImportBenchmarks(BenchContext& context, JobSystem& jobs, const std::string& grid_path) {
+    std::string car_path = JoinPath(context.root, "resources/object/car.blend");
+    std::string car_texture = JoinPath(context.root, "resources/texture/car_texture1.png");
+    Measure(context, "import_car_blend", 5, true, [&]() {
+        TextureArrayPool texture_arrays;
+        Model model;
+        model.SetJobSystem(&jobs);
+        model.SetFixedTexturePath(car_texture);
+        model.LoadModel(car_path, &texture_arrays);
+        texture_arrays.Upload();
+    });
+    Measure(context, "import_generated_grid", 3, true, [&]() {
+        Model model;
+        model.SetJobSystem(&jobs);
+        model.LoadModel(grid_path);
+    });
+}
+
+void RunTextureBenchmarks(BenchContext& context) {
+    // files are mapped up front, so only the decode is timed
+    VirtualFileSystem vfs;
+    std::vector<FileView> images;
+    for (const char* name : { "car_texture1.png", "car_texture2.png", "test_texture.png" }) {
+        FileView image = vfs.Open(JoinPath(context.root, std::string("resources/texture/") + name));
+        if (image.Valid()) {
+            images.push_back(image);
+        }
+    }
+    stbi_set_flip_vertically_on_load(true);
+    Measure(context, "texture_decode_png", 10, false, [&]() {
+        for (const FileView& image : images) {
+            int width = 0;
+            int height = 0;
+            int component_num = 0;
+            unsigned char* data = stbi_load_from_memory(
+                reinterpret_cast<const unsigned char*>(image.Data()),
+                static_cast<int>(image.Size()), &width, &height, &component_num, 0);
+            stbi_image_free(data);
+        }
+    });
+}
+
+void RunCookingBenchmarks(BenchContext& context, const std::string& grid_obj) {
+    // the import flags of Model::LoadModel plus assimp's vertex welding and cache reordering
+    unsigned int flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
+        aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices |
+        aiProcess_ImproveCacheLocality | aiProcess_OptimizeMeshes;
+    Measure(context, "mesh_cook_grid", 3, false, [&]() {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFileFromMemory(grid_obj.data(), grid_obj.size(),
+            flags, "obj");
+        if (scene == nullptr) {
+            std::cerr << "mesh_cook_grid: " << importer.GetErrorString() << std::endl;
+        }
+    });
+    std::string pack_path = "mofu_bench_assets.pack";
+    Measure(context, "pack_build_assets", 3, false, [&]() {
+        VirtualFileSystem::BuildPackFromList(pack_path, context.root,
+            JoinPath(context.root, "pack.list"), PackCompression::NONE);
+    });
+    std::remove(pack_path.c_str());
+}
+
+void RunCullingBenchmarks(BenchContext& context, JobSystem& jobs) {
+    std::mt19937 random(RANDOM_SEED);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 13.0f), glm::vec3(0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 view_projection = projection * view;
+
+    std::vector<glm::vec3> box_min(CULL_OBJECT_NUM);
+    std::vector<glm::vec3> box_max(CULL_OBJECT_NUM);
+    for (size_t i = 0; i < CULL_OBJECT_NUM; i++) {
+        glm::vec3 center(position(random), position(random) * 0.05f, position(random));
+        glm::vec3 half(extent(random));
+        box_min[i] = center - half;
+        box_max[i] = center + half;
+    }
+    size_t visible_num = 0;
+    Measure(context, "cull_frustum_100k", 20, false, [&]() {
+        Frustum frustum(view_projection);
+        visible_num = 0;
+        for (size_t i = 0; i < CULL_OBJECT_NUM; i++) {
+            visible_num += frustum.Intersects(box_min[i], box_max[i]) ? 1 : 0;
+        }
+    });
+
+    // a wall of occluders in front of the camera, then every box is tested against it
+    std::vector<float> wall_positions;
+    std::vector<unsigned int> wall_indices;
+    const int wall_cells = 32;
+    for (int y = 0; y <= wall_cells; y++) {
+        for (int x = 0; x <= wall_cells; x++) {
+            wall_positions.push_back(-20.0f + 40.0f * x / wall_cells);
+            wall_positions.push_back(-5.0f + 15.0f * y / wall_cells);
+            wall_positions.push_back(0.0f);
+        }
+    }
+    for (int y = 0; y < wall_cells; y++) {
+        for (int x = 0; x < wall_cells; x++) {
+            unsigned int a = y * (wall_cells + 1) + x;
+            unsigned int c = a + wall_cells + 1;
+            wall_indices.insert(wall_indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+        }
+    }
+    OcclusionBuffer occlusion;
+    Measure(context, "cull_occlusion_20k", 20, false, [&]() {
+        occlusion.Clear();
+        occlusion.RasterizeTriangles(view_projection, wall_positions.data(), 3 * sizeof(float),
+            wall_positions.size() / 3, wall_indices.data(), wall_indices.size());
+        visible_num = 0;
+        for (size_t i = 0; i < OCCLUSION_QUERY_NUM; i++) {
+            visible_num += occlusion.IsVisible(view_projection, box_min[i], box_max[i]) ? 1 : 0;
+        }
+    });
+
+    World world;
+    for (size_t i = 0; i < CULL_OBJECT_NUM; i++) {
+        Entity entity = world.CreateEntity();
+        Transform transform;
+        transform.position = (box_min[i] + box_max[i]) * 0.5f;
+        world.Transforms().Add(entity, transform);
+        world.MeshRenderers().Add(entity, MeshRenderer{ 0 });
+        Bounds bounds;
+        bounds.local_min = box_min[i] - transform.position;
+        bounds.local_max = box_max[i] - transform.position;
+        world.BoundsPool().Add(entity, bounds);
+    }
+    FrameSnapshot snapshot;
+    Measure(context, "scene_update_collect_100k", 10, false, [&]() {
+        UpdateTransforms(world, &jobs);
+        UpdateBounds(world, &jobs);
+        CollectRenderables(world, view_projection, &jobs, snapshot);
+    });
+}
+
+void RunDrawBenchmarks(BenchContext& context, JobSystem& jobs) {
+    if (!context.has_gl || (!Selected(context, "draw_record_car") &&
+        !Selected(context, "draw_submit_car"))) {
+        // only reports them as skipped
+        Measure(context, "draw_record_car", 0, true, []() {});
+        Measure(context, "draw_submit_car", 0, true, []() {});
+        return;
+    }
+    Shader shader(JoinPath(context.root, "shader/default_shader.vs").c_str(),
+        JoinPath(context.root, "shader/default_shader.fs").c_str());
+    glm::mat4 camera[2] = {
+        glm::lookAt(glm::vec3(0.0f, 2.0f, 13.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+        glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f)
+    };
+    unsigned int camera_buffer = 0;
+    glGenBuffers(1, &camera_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, camera_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(camera), &camera[0][0][0], GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, camera_buffer);
+    shader.BindUniformBlock("CameraBlock", 0);
+    TextureArrayPool texture_arrays;
+    Model model;
+    model.SetJobSystem(&jobs);
+    model.SetFixedTexturePath(JoinPath(context.root, "resources/texture/car_texture1.png"));
+    model.LoadModel(JoinPath(context.root, "resources/object/car.blend"), &texture_arrays);
+    texture_arrays.Upload();
+    std::vector<unsigned int> draw_list;
+    model.FillDrawList(draw_list);
+    // the lighting and shadow samplers need their own units, as in the engine, or GL rejects
+    // the draws for samplers of different types sharing unit 0
+    LightManager light_manager;
+    light_manager.Update(camera[0], camera[1], 0.1f, 100.0f, WINDOW_WIDTH, WINDOW_HEIGHT);
+    light_manager.Upload();
+    CascadedShadowMap shadow_map;
+    if (!shadow_map.Init()) {
+        return;
+    }
+
+    // the instances of a pass, recorded across the job system and replayed in one loop as in
+    // MofuWindow
+    std::vector<glm::mat4> transforms(DRAW_INSTANCE_NUM);
+    for (int i = 0; i < DRAW_INSTANCE_NUM; i++) {
+        transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.1f, 0.0f, 0.0f));
+    }
+    PassRecorder recorder;
+    auto add_instances = [&]() {
+        recorder.Clear();
+        for (int i = 0; i < DRAW_INSTANCE_NUM; i++) {
+            recorder.Add(model, transforms[i], draw_list);
+        }
+    };
+
+    // recording only, which is what the render thread waits for before any GL call
+    Measure(context, "draw_record_car", 50, true, [&]() {
+        add_instances();
+        recorder.Record(&jobs, shader, false);
+    });
+
+    // record plus replay into the driver; the GPU is drained outside the timed region
+    shader.Use();
+    shader.SetBool("use_clustered_lights", true);
+    light_manager.Apply(shader);
+    shader.SetBool("use_shadows", false);
+    shadow_map.Apply(shader);
+    CommandReplayer replayer;
+    Measure(context, "draw_submit_car", 20, true, [&]() {
+        add_instances();
+        recorder.Record(&jobs, shader, false);
+        replayer.Reset();
+        recorder.Replay(replayer);
+        replayer.Finish();
+        glFlush();
+    });
+    glFinish();
+    glDeleteBuffers(1, &camera_buffer);
+}
+
+std::map<std::string, double> LoadThresholds(const std::string& path) {
+    std::map<std::string, double> thresholds;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double threshold_ms = 0.0;
+        if (fields >> name >> threshold_ms) {
+            thresholds[name] = threshold_ms;
+        }
+    }
+    return thresholds;
+}
+
+bool SaveThresholds(const std::string& path, const std::vector<BenchResult>& results,
+    std::map<std::string, double> thresholds, const std::string& renderer) {
+    for (const BenchResult& result : results) {
+        if (!result.skipped && !result.gl_error) {
+            thresholds[result.name] = result.median_ms * THRESHOLD_MARGIN;
+        }
+    }
+    std::ofstream file(path);
+    if (!file) {
+        std::cout << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+    file << "# benchmark name, maximum median time in ms; written by engine_bench "
+        "--update-thresholds\n# measured with GL renderer: " << renderer << "\n";
+    for (const auto& threshold : thresholds) {
+        file << threshold.first << " " << threshold.second << "\n";
+    }
+    return true;
+}
+
+// returns the number of regressions, GL errors included
+int WriteJson(std::ostream& out, const std::vector<BenchResult>& results,
+    const std::map<std::string, double>& thresholds, const std::string& renderer) {
+    int regression_num = 0;
+    out << "{\n  \"renderer\": \"" << renderer << "\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        auto threshold = thresholds.find(result.name);
+        const char* status = "no_threshold";
+        if (result.skipped) {
+            status = "skipped";
+        } else if (result.gl_error) {
+            regression_num++;
+            status = "gl_error";
+        } else if (threshold != thresholds.end()) {
+            bool regressed = result.median_ms > threshold->second;
+            regression_num += regressed ? 1 : 0;
+            status = regressed ? "regressed" : "pass";
+        }
+        out << "    {\"name\": \"" << result.name << "\", \"iterations\": " <<
+            result.iterations << ", \"median_ms\": " << result.median_ms << ", \"min_ms\": " <<
+            result.min_ms << ", \"threshold_ms\": ";
+        if (threshold != thresholds.end()) {
+            out << threshold->second;
+        } else {
+            out << "null";
+        }
+        out << ", \"status\": \"" << status << "\"}" << (i + 1 < results.size() ? "," : "") <<
+            "\n";
+    }
+    out << "  ],\n  \"regressions\": " << regression_num << "\n}\n";
+    return regression_num;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchContext context;
+    context.root = MOFU_SOURCE_ROOT;
+    std::string json_path;
+    std::string thresholds_path = MOFU_DEFAULT_THRESHOLDS;
+    bool update_thresholds = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            context.root = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--thresholds") == 0 && i + 1 < argc) {
+            thresholds_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            context.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--update-thresholds") == 0) {
+            update_thresholds = true;
+        }
+    }
+
+    GLFWwindow* window = nullptr;
+    context.has_gl = CreateContext(window);
+    std::string renderer = context.has_gl ?
+        reinterpret_cast<const char*>(glGetString(GL_RENDERER)) : "none";
+
+    JobSystem jobs;
+    std::string grid_obj = GenerateGridObj();
+    std::string grid_path = "mofu_bench_grid.obj";
+    {
+        std::ofstream grid_file(grid_path, std::ios::binary);
+        grid_file.write(grid_obj.data(), grid_obj.size());
+    }
+
+    RunImportBenchmarks(context, jobs, grid_path);
+    RunTextureBenchmarks(context);
+    RunCookingBenchmarks(context, grid_obj);
+    RunCullingBenchmarks(context, jobs);
+    RunDrawBenchmarks(context, jobs);
+    std::remove(grid_path.c_str());
+
+    std::map<std::string, double> thresholds = LoadThresholds(thresholds_path);
+    int regression_num = 0;
+    if (json_path.empty()) {
+        regression_num = WriteJson(std::cout, context.results, thresholds, renderer);
+    } else {
+        std::ofstream json(json_path);
+        regression_num = WriteJson(json, context.results, thresholds, renderer);
+    }
+    if (update_thresholds) {
+        // a run with GL errors still fails, the broken benchmarks just keep their old thresholds
+        bool saved = SaveThresholds(thresholds_path, context.results, thresholds,
+            renderer);
+        regression_num = saved ? static_cast<int>(std::count_if(context.results.begin(),
+            context.results.end(), [](const BenchResult& result) {
+            return result.gl_error;
+        })) : 1;
+    }
+
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
+    }
+    glfwTerminate();
+    return regression_num > 0 ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// Scaling benchmark for the job system: runs the same ParallelFor workload and a fine-grained
+// dependency fan-out with 1..N workers and prints time and speedup per worker count.
+//
+//   g++ -O2 -std=c++14 -pthread -I../src JobSystemBench.cpp ../src/JobSystem.cpp -o job_bench
+//   ./job_bench [max_workers]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+namespace {
+
+constexpr size_t ELEMENT_NUM = 1 << 22;
+constexpr size_t GRAIN = 4096;
+constexpr int REPEAT_NUM = 5;
+constexpr int TASK_NUM = 1 << 16;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double RunParallelFor(JobSystem& jobs, std::vector<float>& data) {
+    double best = 1e30;
+    for (int r = 0; r < REPEAT_NUM; r++) {
+        auto start = std::chrono::steady_clock::now();
+        jobs.ParallelFor(data.size(), GRAIN, [&data](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                float x = data[i];
+                for (int k = 0; k < 16; k++) {
+                    x = std::sqrt(x * x + 1.0f) * 0.5f;
+                }
+                data[i] = x;
+            }
+        });
+        best = std::min(best, Seconds(start));
+    }
+    return best;
+}
+
+double RunSmallJobs(JobSystem& jobs) {
+    double best = 1e30;
+    std::vector<float> results(TASK_NUM);
+    for (int r = 0; r < REPEAT_NUM; r++) {
+        auto start = std::chrono::steady_clock::now();
+        JobCounter counter;
+        for (int i = 0; i < TASK_NUM; i++) {
+            jobs.Run([&results, i]() {
+                float x = static_cast<float>(i);
+                for (int k = 0; k < 64; k++) {
+                    x = std::sqrt(x + 1.0f);
+                }
+                results[i] = x;
+            }, &counter);
+        }
+        jobs.Wait(counter);
+        best = std::min(best, Seconds(start));
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned int max_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    if (argc > 1) {
+        max_workers = static_cast<unsigned int>(std::max(std::atoi(argv[1]), 1));
+    }
+    std::vector<float> data(ELEMENT_NUM, 1.0f);
+    double base_for = 0.0;
+    double base_small = 0.0;
+    std::printf("workers,parallel_for_ms,parallel_for_speedup,small_jobs_ms,small_jobs_speedup\n");
+    for (unsigned int workers = 1; workers <= max_workers; workers++) {
+        JobSystem jobs(workers);
+        double time_for = RunParallelFor(jobs, data);
+        double time_small = RunSmallJobs(jobs);
+        if (workers == 1) {
+            base_for = time_for;
+            base_small = time_small;
+        }
+        std::printf("%u,%.3f,%.2f,%.3f,%.2f\n", workers, time_for * 1000.0, base_for / time_for,
+            time_small * 1000.0, base_small / time_small);
+    }
+    return 0;
+}
@@ -1,4 +1,5 @@
 #version 330 core
+#extension GL_ARB_bindless_texture : enable
 
 struct Material {
     float shininess;
@@ -21,37 +22,147 @@ struct Light {
 in vec3 frag_pos;
 in vec3 normal;
 in vec2 tex_coords;
+in float view_depth;
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+// only bound during the transparent pass, see TransparencyPass
+layout (location = 1) out vec4 oit_weight;
 
 uniform bool use_material;
+uniform bool oit_pass;
 uniform Material material;
 uniform Light light;
 uniform vec3 view_pos;
+uniform bool use_clustered_lights;
+uniform samplerBuffer light_data;
+uniform usamplerBuffer cluster_grid;
+uniform usamplerBuffer light_indices;
+uniform ivec3 cluster_dims;
+uniform vec2 cluster_tile_size;
+uniform float cluster_near;
+uniform float cluster_depth_scale;
+uniform bool use_shadows;
+uniform sampler2DArrayShadow shadow_map;
+uniform mat4 light_space[4];
+uniform vec4 cascade_splits;
+uniform int cascade_valid;
+uniform bool use_texture_array;
+uniform int diffuse_layer;
 uniform sampler2D texture_diffuse1;
+#ifdef GL_ARB_bindless_texture
+layout(bindless_sampler) uniform sampler2DArray texture_array;
+#else
+uniform sampler2DArray texture_array;
+#endif
 
-void main() {
-    if (use_material) {
-        // ambient
-        vec3 ambient = light.ambient * material.ambient;
+vec3 ClusteredLights(vec3 norm, vec3 view_dir, vec3 diffuse_color, vec3 specular_color,
+    float shininess) {
+    ivec2 tile = ivec2(gl_FragCoord.xy / cluster_tile_size);
+    int slice = int(log(max(view_depth, cluster_near) / cluster_near) * cluster_depth_scale);
+    tile = clamp(tile, ivec2(0), cluster_dims.xy - 1);
+    slice = clamp(slice, 0, cluster_dims.z - 1);
+    int cluster = (slice * cluster_dims.y + tile.y) * cluster_dims.x + tile.x;
+    uvec2 range = texelFetch(cluster_grid, cluster).xy;
 
-        // diffuse
-        vec3 norm = normalize(normal);
-        // vec3 light_dir = normalize(light.position - frag_pos);
-        vec3 light_dir = normalize(-light.direction);
-        float diff = max(dot(norm, light_dir), 0.0);
-        vec3 diffuse = light.diffuse * diff * material.diffuse;
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(light_indices, int(range.x + i)).r);
+        vec4 position_range = texelFetch(light_data, light * 3);
+        vec4 color_inner = texelFetch(light_data, light * 3 + 1);
+        vec4 direction_outer = texelFetch(light_data, light * 3 + 2);
 
-        // specular
-        vec3 view_dir = normalize(view_pos - frag_pos);
+        vec3 to_light = position_range.xyz - frag_pos;
+        float dist = length(to_light);
+        vec3 light_dir = to_light / max(dist, 1e-4);
+        float window = clamp(1.0 - pow(dist / position_range.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (dist * dist + 1.0);
+        float cone = dot(-light_dir, direction_outer.xyz);
+        attenuation *= clamp((cone - direction_outer.w) /
+            max(color_inner.w - direction_outer.w, 1e-4), 0.0, 1.0);
+
+        float diff = max(dot(norm, light_dir), 0.0);
         vec3 reflect_dir = reflect(-light_dir, norm);
-        float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
-        vec3 specular = light.specular * spec * material.specular;
+        float spec = pow(max(dot(view_dir, reflect_dir), 0.0), shininess);
+        result += color_inner.rgb * attenuation * (diff * diffuse_color + spec * specular_color);
+    }
+    return result;
+}
+
+float DirectionalShadow(vec3 norm, vec3 light_dir) {
+    int cascade = 0;
+    while (cascade < 3 && view_depth > cascade_splits[cascade]) {
+        cascade++;
+    }
+    if ((cascade_valid & (1 << cascade)) == 0) {
+        return 1.0;
+    }
+    vec2 texel = 1.0 / vec2(textureSize(shadow_map, 0).xy);
+    // push the lookup along the normal by about a texel against acne on grazing surfaces
+    float normal_offset = 2.0 / (light_space[cascade][0][0] * textureSize(shadow_map, 0).x);
+    vec4 light_pos = light_space[cascade] * vec4(frag_pos + norm * normal_offset, 1.0);
+    vec3 coords = light_pos.xyz / light_pos.w * 0.5 + 0.5;
+    // a cached cascade may not cover this fragment yet
+    if (any(lessThan(coords, vec3(0.0))) || any(greaterThan(coords, vec3(1.0)))) {
+        return 1.0;
+    }
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(shadow_map, vec4(coords.xy + vec2(x, y) * texel, float(cascade),
+                coords.z));
+        }
+    }
+    return lit / 9.0;
+}
 
-        // vec3 result = ambient + diffuse + specular;
-        vec3 result = material.diffuse;
-        FragColor = vec4(result, material.opacity);
+void main() {
+    vec4 base_color;
+    vec3 specular_color;
+    float shininess;
+    if (use_material) {
+        base_color = vec4(material.diffuse, material.opacity);
+        specular_color = material.specular;
+        shininess = max(material.shininess, 1.0);
+    } else if (use_texture_array) {
+        // meshes without a diffuse texture have no layer and are shaded white
+        base_color = diffuse_layer >= 0 ?
+            texture(texture_array, vec3(tex_coords, float(diffuse_layer))) : vec4(1.0);
+        specular_color = vec3(0.5);
+        shininess = 32.0;
     } else {
-        FragColor = texture(texture_diffuse1, tex_coords);
+        base_color = texture(texture_diffuse1, tex_coords);
+        specular_color = vec3(0.5);
+        shininess = 32.0;
+    }
+
+    // ambient
+    vec3 ambient = light.ambient * base_color.rgb;
+
+    // diffuse
+    vec3 norm = normalize(normal);
+    vec3 light_dir = normalize(-light.direction);
+    float diff = max(dot(norm, light_dir), 0.0);
+    vec3 diffuse = light.diffuse * diff * base_color.rgb;
+
+    // specular
+    vec3 view_dir = normalize(view_pos - frag_pos);
+    vec3 reflect_dir = reflect(-light_dir, norm);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), shininess);
+    vec3 specular = light.specular * spec * specular_color;
+
+    float shadow = use_shadows ? DirectionalShadow(norm, light_dir) : 1.0;
+    vec3 result = ambient + shadow * (diffuse + specular);
+    if (use_clustered_lights) {
+        result += ClusteredLights(norm, view_dir, base_color.rgb, specular_color, shininess);
+    }
+    if (oit_pass) {
+        // depth weight of McGuire and Bavoil's equation 10, nearer layers dominate the average
+        float alpha = use_material ? material.opacity : base_color.a * material.opacity;
+        float weight = alpha * clamp(10.0 / (1e-5 + pow(view_depth / 5.0, 2.0) +
+            pow(view_depth / 200.0, 6.0)), 1e-2, 3e3);
+        FragColor = vec4(result * alpha * weight, alpha);
+        oit_weight = vec4(alpha * weight, 0.0, 0.0, 0.0);
+        return;
     }
+    FragColor = vec4(result, base_color.a);
 }
@@ -7,14 +7,23 @@ layout (location = 2) in vec2 aTexCoords;
 out vec3 frag_pos;
 out vec3 normal;
 out vec2 tex_coords;
+out float view_depth;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-pass camera, streamed through the ring buffer by MofuWindow::BindCamera
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+};
+
+invariant gl_Position;
 
 void main() {
-    frag_pos = aPos;
-    normal = aNormal;
-    tex_coords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec4 world_pos = model * vec4(aPos, 1.0);
+    vec4 view_pos = view * world_pos;
+    frag_pos = world_pos.xyz;
+    normal = mat3(model) * aNormal;
+    tex_coords = aTexCoords;
+    view_depth = -view_pos.z;
+    gl_Position = projection * view_pos;
 }
@@ -0,0 +1,19 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+// per-pass camera, streamed through the ring buffer by MofuWindow::BindCamera
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+};
+
+// must match default_shader.vs bit for bit, the main pass tests against this depth with GL_EQUAL
+invariant gl_Position;
+
+void main() {
+    vec4 world_pos = model * vec4(aPos, 1.0);
+    vec4 view_pos = view * world_pos;
+    gl_Position = projection * view_pos;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D accumulation;
+uniform sampler2D weight;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 accum = texelFetch(accumulation, texel, 0);
+    // alpha holds the product of (1 - alpha) over all layers, 1 means nothing transparent here
+    float revealage = accum.a;
+    if (revealage >= 0.999) {
+        discard;
+    }
+    float weight_sum = texelFetch(weight, texel, 0).r;
+    vec3 average = accum.rgb / max(weight_sum, 1e-5);
+    FragColor = vec4(average, 1.0 - revealage);
+}
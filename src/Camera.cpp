@@ -22,17 +22,18 @@ Camera::Camera(float pos_x, float pos_y, float pos_z, float up_x, float up_y, fl
     UpdateCameraVectors();
 }
 
-glm::mat4 Camera::GetViewMatrix() {
-    return glm::lookAt(position_, position_ + front_, up_);
+Camera Camera::Interpolate(const Camera& from, const Camera& to, float alpha) {
+    Camera camera = to;
+    camera.position_ = glm::mix(from.position_, to.position_, alpha);
+    camera.yaw_ = glm::mix(from.yaw_, to.yaw_, alpha);
+    camera.pitch_ = glm::mix(from.pitch_, to.pitch_, alpha);
+    camera.zoom_ = glm::mix(from.zoom_, to.zoom_, alpha);
+    camera.UpdateCameraVectors();
+    return camera;
 }
 
-glm::mat4 Camera::GetModelMatrix() {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(model_scale_));
-    model = glm::rotate(model, glm::radians(model_yaw_), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(-model_pitch_), glm::vec3(0.0f, 0.0f, 1.0f));
-    return model;
+glm::mat4 Camera::GetViewMatrix() {
+    return glm::lookAt(position_, position_ + front_, up_);
 }
 
 void Camera::ProcessKeyboard(CameraMovement direction, float delta_time) {
@@ -55,8 +56,6 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, bool constrain_p
     xoffset *= mouse_sensitivity_;
     yoffset *= mouse_sensitivity_;
 
-    /*
-    // TODO: affect model yaw/pitch instead of camera
     yaw_ += xoffset;
     pitch_ += yoffset;
 
@@ -70,18 +69,6 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, bool constrain_p
     }
 
     UpdateCameraVectors();
-    */
-    model_yaw_ += xoffset;
-    model_pitch_ += yoffset;
-
-    if (constrain_pitch) {
-        if (model_pitch_ > 89.0f) {
-            model_pitch_ = 89.0f;
-        }
-        if (model_pitch_ < -89.0f) {
-            model_pitch_ = -89.0f;
-        }
-    }
 }
 
 void Camera::ProcessMouseScroll(float yoffset) {
@@ -23,12 +23,13 @@ public:
         float pitch);
     ~Camera() = default;
 
+    static Camera Interpolate(const Camera& from, const Camera& to, float alpha);
     glm::mat4 GetViewMatrix();
-    glm::mat4 GetModelMatrix();
     void ProcessKeyboard(CameraMovement direction, float delta_time);
     void ProcessMouseMovement(float xoffset, float yoffset, bool constrain_pitch = true);
     void ProcessMouseScroll(float yoffset);
     inline float Zoom() const;
+    inline glm::vec3 Position() const;
 
 private:
     void UpdateCameraVectors();
@@ -38,9 +39,6 @@ private:
     float movement_speed_ = 0.0f;
     float mouse_sensitivity_ = 0.0f;
     float zoom_ = 0.0f;
-    float model_yaw_ = 0.0f;
-    float model_pitch_ = 0.0f;
-    float model_scale_ = 1.0f;
     glm::vec3 position_;
     glm::vec3 front_;
     glm::vec3 up_;
@@ -49,7 +47,7 @@ private:
 
     static constexpr float YAW = -90.0f;
     static constexpr float PITCH = 0.0f;
-    static constexpr float SPEED = 0.5f;
+    static constexpr float SPEED = 5.0f;
     static constexpr float SENSITIVITY = 0.1f;
     static constexpr float ZOOM = 45.0f;
 };
@@ -58,4 +56,8 @@ float Camera::Zoom() const {
     return zoom_;
 }
 
+glm::vec3 Camera::Position() const {
+    return position_;
+}
+
 #endif  // SRC_CAMERA_H_
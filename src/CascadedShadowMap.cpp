@@ -0,0 +1,202 @@
+#include "CascadedShadowMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <GL/glew.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Culling.h"
+
+namespace {
+
+// blend between logarithmic and uniform splits
+constexpr float SPLIT_LAMBDA = 0.75f;
+// cached cascades cover this much more than their slice so small camera moves keep them valid
+constexpr float CACHE_MARGIN = 1.5f;
+// casters up to this far in front of a cascade still land in its depth range
+constexpr float CASTER_DISTANCE = 50.0f;
+
+}  // namespace
+
+CascadedShadowMap::~CascadedShadowMap() {
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &texture_);
+    }
+}
+
+bool CascadedShadowMap::Init() {
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, RESOLUTION, RESOLUTION,
+        CASCADE_NUM, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cout << "ERROR::SHADOW_MAP::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void CascadedShadowMap::Update(const glm::mat4& view, const glm::mat4& projection,
+    float z_near, float z_far, const glm::vec3& light_direction) {
+    glm::vec3 direction = glm::normalize(light_direction);
+    if (direction != light_direction_) {
+        light_direction_ = direction;
+        MarkStaticDirty();
+    }
+
+    // view space corners on the near plane, a slice at depth d is the same rays scaled by d/near
+    glm::mat4 inverse_projection = glm::inverse(projection);
+    glm::mat4 inverse_view = glm::inverse(view);
+    glm::vec3 near_corners[4];
+    for (int i = 0; i < 4; i++) {
+        glm::vec4 corner = inverse_projection * glm::vec4((i & 1) ? 1.0f : -1.0f,
+            (i & 2) ? 1.0f : -1.0f, -1.0f, 1.0f);
+        near_corners[i] = glm::vec3(corner) / corner.w;
+    }
+
+    float split_near = z_near;
+    int budget = budget_;
+    rendered_num_ = 0;
+    for (int c = 0; c < CASCADE_NUM; c++) {
+        Cascade& cascade = cascades_[c];
+        float ratio = static_cast<float>(c + 1) / CASCADE_NUM;
+        float split_far = SPLIT_LAMBDA * z_near * std::pow(z_far / z_near, ratio) +
+            (1.0f - SPLIT_LAMBDA) * (z_near + (z_far - z_near) * ratio);
+
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 8; i++) {
+            float scale = (i < 4 ? split_near : split_far) / z_near;
+            corners[i] = glm::vec3(inverse_view * glm::vec4(near_corners[i % 4] * scale, 1.0f));
+            center += corners[i];
+        }
+        center = center / 8.0f;
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners) {
+            radius = std::max(radius, glm::length(corner - center));
+        }
+        // a radius that only changes in coarse steps keeps the texel size constant
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        split_near = split_far;
+
+        cascade.render = false;
+        if (c < FIRST_CACHED_CASCADE) {
+            Fit(cascade, center, radius);
+            cascade.split_far = split_far;
+            cascade.render = true;
+            budget--;
+            continue;
+        }
+        bool contained = cascade.valid &&
+            glm::length(center - cascade.center) + radius <= cascade.radius;
+        if (!contained || cascade.dirty) {
+            if (budget <= 0) {
+                // stays stale this frame, its old fit and contents still match each other
+                continue;
+            }
+            Fit(cascade, center, radius * CACHE_MARGIN);
+            cascade.split_far = split_far;
+            cascade.render = true;
+            budget--;
+        }
+    }
+}
+
+void CascadedShadowMap::Fit(Cascade& cascade, const glm::vec3& center, float radius) const {
+    glm::vec3 up = std::abs(light_direction_.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) :
+        glm::vec3(0.0f, 1.0f, 0.0f);
+    float distance = radius + CASTER_DISTANCE;
+    cascade.view = glm::lookAt(center - light_direction_ * distance, center, up);
+    cascade.projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, distance + radius);
+
+    // move the projection by the sub-texel offset of the world origin so texels stay put
+    glm::vec4 origin = cascade.projection * cascade.view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float texel_x = origin.x * RESOLUTION * 0.5f;
+    float texel_y = origin.y * RESOLUTION * 0.5f;
+    cascade.projection[3][0] += (std::round(texel_x) - texel_x) * 2.0f / RESOLUTION;
+    cascade.projection[3][1] += (std::round(texel_y) - texel_y) * 2.0f / RESOLUTION;
+    cascade.center = center;
+    cascade.radius = radius;
+}
+
+void CascadedShadowMap::MarkStaticDirty() {
+    for (Cascade& cascade : cascades_) {
+        cascade.dirty = true;
+    }
+}
+
+void CascadedShadowMap::MarkStaticDirty(const glm::vec3& bounds_min,
+    const glm::vec3& bounds_max) {
+    for (Cascade& cascade : cascades_) {
+        // the ortho volume reaches back to the light, so it holds every caster of the cascade
+        if (cascade.valid &&
+            Frustum(cascade.projection * cascade.view).Intersects(bounds_min, bounds_max)) {
+            cascade.dirty = true;
+        }
+    }
+}
+
+void CascadedShadowMap::SetBudget(int cascades_per_frame) {
+    // the per-frame cascades always render, the budget only limits cached refreshes
+    budget_ = std::max(cascades_per_frame, FIRST_CACHED_CASCADE + 1);
+}
+
+void CascadedShadowMap::BeginCascade(int cascade) {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_, 0, cascade);
+    glViewport(0, 0, RESOLUTION, RESOLUTION);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+}
+
+void CascadedShadowMap::EndCascade(int cascade, size_t caster_num) {
+    cascades_[cascade].caster_num = caster_num;
+    cascades_[cascade].valid = true;
+    cascades_[cascade].dirty = false;
+    rendered_num_++;
+}
+
+void CascadedShadowMap::End(int width, int height) {
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+}
+
+void CascadedShadowMap::Apply(const Shader& shader) const {
+    glm::mat4 light_space[CASCADE_NUM];
+    float splits[CASCADE_NUM];
+    int valid_mask = 0;
+    for (int c = 0; c < CASCADE_NUM; c++) {
+        light_space[c] = cascades_[c].projection * cascades_[c].view;
+        splits[c] = cascades_[c].split_far;
+        valid_mask |= cascades_[c].valid ? 1 << c : 0;
+    }
+    glActiveTexture(GL_TEXTURE0 + SHADOW_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.SetInt("shadow_map", SHADOW_UNIT);
+    glUniformMatrix4fv(shader.Location("light_space"), CASCADE_NUM, GL_FALSE,
+        &light_space[0][0][0]);
+    shader.SetVec4("cascade_splits", glm::vec4(splits[0], splits[1], splits[2], splits[3]));
+    shader.SetInt("cascade_valid", valid_mask);
+}
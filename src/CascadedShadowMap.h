@@ -0,0 +1,92 @@
+#ifndef SRC_CASCADEDSHADOWMAP_H_
+#define SRC_CASCADEDSHADOWMAP_H_
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// Directional light shadows split into cascades along the view depth, all stored as layers of
+// one depth texture array. Every cascade is fitted to a bounding sphere of its slice of the view
+// frustum and snapped to whole shadow texels, so the map does not shimmer while the camera moves.
+// Near cascades are refitted and redrawn every frame with all casters. Distant cascades are
+// fitted with a margin, hold static casters only and are cached: they are redrawn only when the
+// light changes, static geometry changes inside them, or the view slice leaves the cached fit,
+// and at most budget cascades are drawn per frame.
+class CascadedShadowMap {
+public:
+    CascadedShadowMap() = default;
+    ~CascadedShadowMap();
+
+    bool Init();
+    void Update(const glm::mat4& view, const glm::mat4& projection, float z_near, float z_far,
+        const glm::vec3& light_direction);
+    void MarkStaticDirty();
+    // only the cascades whose light volume touches the box
+    void MarkStaticDirty(const glm::vec3& bounds_min, const glm::vec3& bounds_max);
+    inline bool Cached(int cascade) const;
+    void SetBudget(int cascades_per_frame);
+    inline bool NeedsRender(int cascade) const;
+    inline const glm::mat4& LightView(int cascade) const;
+    inline const glm::mat4& LightProjection(int cascade) const;
+    void BeginCascade(int cascade);
+    void EndCascade(int cascade, size_t caster_num);
+    void End(int width, int height);
+    void Apply(const Shader& shader) const;
+    inline size_t CasterNum(int cascade) const;
+    inline int RenderedNum() const;
+
+    static constexpr int CASCADE_NUM = 4;
+    static constexpr int FIRST_CACHED_CASCADE = 2;
+    static constexpr int RESOLUTION = 1024;
+    static constexpr int SHADOW_UNIT = 12;
+
+private:
+    struct Cascade {
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+        float split_far = 0.0f;
+        bool valid = false;
+        bool dirty = true;
+        bool render = false;
+        size_t caster_num = 0;
+    };
+
+    void Fit(Cascade& cascade, const glm::vec3& center, float radius) const;
+
+    Cascade cascades_[CASCADE_NUM];
+    glm::vec3 light_direction_ = glm::vec3(0.0f);
+    int budget_ = FIRST_CACHED_CASCADE + 1;
+    int rendered_num_ = 0;
+    unsigned int texture_ = 0;
+    unsigned int fbo_ = 0;
+};
+
+bool CascadedShadowMap::Cached(int cascade) const {
+    return cascade >= FIRST_CACHED_CASCADE;
+}
+
+bool CascadedShadowMap::NeedsRender(int cascade) const {
+    return cascades_[cascade].render;
+}
+
+const glm::mat4& CascadedShadowMap::LightView(int cascade) const {
+    return cascades_[cascade].view;
+}
+
+const glm::mat4& CascadedShadowMap::LightProjection(int cascade) const {
+    return cascades_[cascade].projection;
+}
+
+size_t CascadedShadowMap::CasterNum(int cascade) const {
+    return cascades_[cascade].caster_num;
+}
+
+int CascadedShadowMap::RenderedNum() const {
+    return rendered_num_;
+}
+
+#endif  // SRC_CASCADEDSHADOWMAP_H_
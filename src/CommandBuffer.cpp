@@ -0,0 +1,11 @@
+#include "CommandBuffer.h"
+
+void CommandBuffer::Append(const CommandBuffer& other) {
+    data_.insert(data_.end(), other.data_.begin(), other.data_.end());
+    command_num_ += other.command_num_;
+}
+
+void CommandBuffer::Reset() {
+    data_.clear();
+    command_num_ = 0;
+}
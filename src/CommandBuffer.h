@@ -0,0 +1,134 @@
+#ifndef SRC_COMMANDBUFFER_H_
+#define SRC_COMMANDBUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Render commands are small POD structs recorded back to back into linear memory. Recording has
+// no GL dependency and may happen on any thread; a backend (see CommandReplayer) walks the buffer
+// on the context thread.
+enum class CommandType : uint32_t {
+    BIND_PROGRAM,
+    BIND_VERTEX_ARRAY,
+    BIND_TEXTURE,
+    UNIFORM_INT,
+    UNIFORM_FLOAT,
+    UNIFORM_VEC3,
+    UNIFORM_MAT4,
+    UNIFORM_HANDLE,
+    DRAW_INDEXED
+};
+
+enum class TextureTarget : uint32_t {
+    TEXTURE_2D,
+    TEXTURE_2D_ARRAY
+};
+
+struct BindProgramCommand {
+    static constexpr CommandType TYPE = CommandType::BIND_PROGRAM;
+    unsigned int program;
+};
+
+struct BindVertexArrayCommand {
+    static constexpr CommandType TYPE = CommandType::BIND_VERTEX_ARRAY;
+    unsigned int vertex_array;
+};
+
+struct BindTextureCommand {
+    static constexpr CommandType TYPE = CommandType::BIND_TEXTURE;
+    unsigned int unit;
+    TextureTarget target;
+    unsigned int texture;
+};
+
+struct UniformIntCommand {
+    static constexpr CommandType TYPE = CommandType::UNIFORM_INT;
+    int location;
+    int value;
+};
+
+struct UniformFloatCommand {
+    static constexpr CommandType TYPE = CommandType::UNIFORM_FLOAT;
+    int location;
+    float value;
+};
+
+struct UniformVec3Command {
+    static constexpr CommandType TYPE = CommandType::UNIFORM_VEC3;
+    int location;
+    float value[3];
+};
+
+struct UniformMat4Command {
+    static constexpr CommandType TYPE = CommandType::UNIFORM_MAT4;
+    int location;
+    float value[16];
+};
+
+struct UniformHandleCommand {
+    static constexpr CommandType TYPE = CommandType::UNIFORM_HANDLE;
+    int location;
+    uint64_t handle;
+};
+
+struct DrawIndexedCommand {
+    static constexpr CommandType TYPE = CommandType::DRAW_INDEXED;
+    unsigned int index_num;
+    unsigned int first_index;
+};
+
+struct CommandHeader {
+    CommandType type;
+    uint32_t size;
+};
+
+class CommandBuffer {
+public:
+    CommandBuffer() = default;
+    ~CommandBuffer() = default;
+
+    template <typename T>
+    void Push(const T& command);
+    void Append(const CommandBuffer& other);
+    void Reset();
+    inline const unsigned char* Data() const;
+    inline size_t Size() const;
+    inline size_t CommandNum() const;
+
+    static constexpr size_t ALIGNMENT = 8;
+
+private:
+    std::vector<unsigned char> data_ = {};
+    size_t command_num_ = 0;
+};
+
+template <typename T>
+void CommandBuffer::Push(const T& command) {
+    static_assert(std::is_trivially_copyable<T>::value, "commands must be trivially copyable");
+    static_assert(alignof(T) <= ALIGNMENT, "command alignment exceeds buffer alignment");
+    constexpr size_t payload = (sizeof(T) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    constexpr size_t size = sizeof(CommandHeader) + payload;
+    CommandHeader header = { T::TYPE, static_cast<uint32_t>(size) };
+    size_t offset = data_.size();
+    data_.resize(offset + size);
+    std::memcpy(&data_[offset], &header, sizeof(CommandHeader));
+    std::memcpy(&data_[offset + sizeof(CommandHeader)], &command, sizeof(T));
+    command_num_++;
+}
+
+const unsigned char* CommandBuffer::Data() const {
+    return data_.data();
+}
+
+size_t CommandBuffer::Size() const {
+    return data_.size();
+}
+
+size_t CommandBuffer::CommandNum() const {
+    return command_num_;
+}
+
+#endif  // SRC_COMMANDBUFFER_H_
@@ -0,0 +1,167 @@
+#include "CommandReplayer.h"
+
+#include <cstring>
+
+#include <GL/glew.h>
+
+namespace {
+
+template <typename T>
+const T& Payload(const unsigned char* command) {
+    return *reinterpret_cast<const T*>(command + sizeof(CommandHeader));
+}
+
+GLenum ToGL(TextureTarget target) {
+    return target == TextureTarget::TEXTURE_2D_ARRAY ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+}
+
+}  // namespace
+
+CommandReplayer::CommandReplayer() {
+    Reset();
+}
+
+void CommandReplayer::Replay(const CommandBuffer& commands) {
+    const unsigned char* current = commands.Data();
+    const unsigned char* end = current + commands.Size();
+    while (current < end) {
+        const CommandHeader* header = reinterpret_cast<const CommandHeader*>(current);
+        bool executed = true;
+        switch (header->type) {
+        case CommandType::BIND_PROGRAM: {
+            const BindProgramCommand& command = Payload<BindProgramCommand>(current);
+            if (command.program != program_) {
+                glUseProgram(command.program);
+                program_ = command.program;
+                uniforms_.clear();
+            } else {
+                executed = false;
+            }
+            break;
+        }
+        case CommandType::BIND_VERTEX_ARRAY: {
+            const BindVertexArrayCommand& command = Payload<BindVertexArrayCommand>(current);
+            if (command.vertex_array != vertex_array_) {
+                glBindVertexArray(command.vertex_array);
+                vertex_array_ = command.vertex_array;
+            } else {
+                executed = false;
+            }
+            break;
+        }
+        case CommandType::BIND_TEXTURE: {
+            const BindTextureCommand& command = Payload<BindTextureCommand>(current);
+            unsigned int target = static_cast<unsigned int>(command.target);
+            if (command.unit >= MAX_TEXTURE_UNITS || target >= TARGET_NUM ||
+                textures_[target][command.unit] != command.texture) {
+                if (command.unit != active_unit_) {
+                    glActiveTexture(GL_TEXTURE0 + command.unit);
+                    active_unit_ = command.unit;
+                }
+                glBindTexture(ToGL(command.target), command.texture);
+                if (command.unit < MAX_TEXTURE_UNITS && target < TARGET_NUM) {
+                    textures_[target][command.unit] = command.texture;
+                }
+            } else {
+                executed = false;
+            }
+            break;
+        }
+        case CommandType::UNIFORM_INT: {
+            const UniformIntCommand& command = Payload<UniformIntCommand>(current);
+            executed = UniformChanged(command.location, &command.value, sizeof(command.value));
+            if (executed) {
+                glUniform1i(command.location, command.value);
+            }
+            break;
+        }
+        case CommandType::UNIFORM_FLOAT: {
+            const UniformFloatCommand& command = Payload<UniformFloatCommand>(current);
+            executed = UniformChanged(command.location, &command.value, sizeof(command.value));
+            if (executed) {
+                glUniform1f(command.location, command.value);
+            }
+            break;
+        }
+        case CommandType::UNIFORM_VEC3: {
+            const UniformVec3Command& command = Payload<UniformVec3Command>(current);
+            executed = UniformChanged(command.location, command.value, sizeof(command.value));
+            if (executed) {
+                glUniform3fv(command.location, 1, command.value);
+            }
+            break;
+        }
+        case CommandType::UNIFORM_MAT4: {
+            const UniformMat4Command& command = Payload<UniformMat4Command>(current);
+            executed = UniformChanged(command.location, command.value, sizeof(command.value));
+            if (executed) {
+                glUniformMatrix4fv(command.location, 1, GL_FALSE, command.value);
+            }
+            break;
+        }
+        case CommandType::UNIFORM_HANDLE: {
+            const UniformHandleCommand& command = Payload<UniformHandleCommand>(current);
+            executed = UniformChanged(command.location, &command.handle, sizeof(command.handle));
+            if (executed) {
+                glUniformHandleui64ARB(command.location, command.handle);
+            }
+            break;
+        }
+        case CommandType::DRAW_INDEXED: {
+            const DrawIndexedCommand& command = Payload<DrawIndexedCommand>(current);
+            glDrawElements(GL_TRIANGLES, command.index_num, GL_UNSIGNED_INT,
+                reinterpret_cast<void*>(command.first_index * sizeof(unsigned int)));
+            draw_num_++;
+            break;
+        }
+        }
+        if (executed) {
+            executed_num_++;
+        } else {
+            skipped_num_++;
+        }
+        current += header->size;
+    }
+}
+
+void CommandReplayer::Finish() {
+    if (vertex_array_ != 0) {
+        glBindVertexArray(0);
+        vertex_array_ = 0;
+    }
+    if (active_unit_ != 0) {
+        glActiveTexture(GL_TEXTURE0);
+        active_unit_ = 0;
+    }
+}
+
+void CommandReplayer::Reset() {
+    program_ = UNKNOWN;
+    vertex_array_ = UNKNOWN;
+    active_unit_ = UNKNOWN;
+    for (unsigned int i = 0; i < TARGET_NUM; i++) {
+        for (unsigned int j = 0; j < MAX_TEXTURE_UNITS; j++) {
+            textures_[i][j] = UNKNOWN;
+        }
+    }
+    uniforms_.clear();
+    executed_num_ = 0;
+    skipped_num_ = 0;
+    draw_num_ = 0;
+}
+
+bool CommandReplayer::UniformChanged(int location, const void* value, uint32_t size) {
+    if (location < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(location) >= uniforms_.size()) {
+        uniforms_.resize(location + 1);
+    }
+    UniformValue& cached = uniforms_[location];
+    if (cached.size == size && std::memcmp(cached.bytes, value, size) == 0) {
+        return false;
+    }
+    cached.size = size;
+    std::memcpy(cached.bytes, value, size);
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SRC_COMMANDREPLAYER_H_
+#define SRC_COMMANDREPLAYER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CommandBuffer.h"
+
+// Executes recorded command buffers against GL. Must run on the context thread. Bindings and
+// uniform values are shadowed so that redundant state changes are dropped; call Reset() whenever
+// GL state may have been changed outside of Replay(). The shadowed state carries over from one
+// buffer to the next, so a pass replays all of its buffers and then calls Finish() once to
+// unbind the vertex array and go back to texture unit 0.
+class CommandReplayer {
+public:
+    CommandReplayer();
+    ~CommandReplayer() = default;
+
+    void Replay(const CommandBuffer& commands);
+    void Finish();
+    void Reset();
+    inline size_t ExecutedNum() const;
+    inline size_t SkippedNum() const;
+    inline size_t DrawNum() const;
+
+    static constexpr unsigned int MAX_TEXTURE_UNITS = 16;
+
+private:
+    struct UniformValue {
+        uint32_t size = 0;
+        unsigned char bytes[64] = {};
+    };
+
+    bool UniformChanged(int location, const void* value, uint32_t size);
+
+    static constexpr unsigned int UNKNOWN = ~0u;
+    static constexpr unsigned int TARGET_NUM = 2;
+
+    unsigned int program_ = UNKNOWN;
+    unsigned int vertex_array_ = UNKNOWN;
+    unsigned int active_unit_ = UNKNOWN;
+    unsigned int textures_[TARGET_NUM][MAX_TEXTURE_UNITS] = {};
+    std::vector<UniformValue> uniforms_ = {};
+    size_t executed_num_ = 0;
+    size_t skipped_num_ = 0;
+    size_t draw_num_ = 0;
+};
+
+size_t CommandReplayer::ExecutedNum() const {
+    return executed_num_;
+}
+
+size_t CommandReplayer::SkippedNum() const {
+    return skipped_num_;
+}
+
+size_t CommandReplayer::DrawNum() const {
+    return draw_num_;
+}
+
+#endif  // SRC_COMMANDREPLAYER_H_
@@ -0,0 +1,38 @@
+#ifndef SRC_COMPONENTS_H_
+#define SRC_COMPONENTS_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "LightManager.h"
+
+// Plain data components stored by World. Systems fill the derived fields (world matrices and
+// world bounds) every frame.
+struct Transform {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+    glm::mat4 world = glm::mat4(1.0f);
+};
+
+// Draws one instance of a shared Model asset, indexed into the renderer's asset list. Static
+// instances never move after they are added, so their shadows can be cached.
+struct MeshRenderer {
+    unsigned int model = 0;
+    bool casts_shadows = true;
+    bool is_static = true;
+};
+
+struct Bounds {
+    glm::vec3 local_min = glm::vec3(0.0f);
+    glm::vec3 local_max = glm::vec3(0.0f);
+    glm::vec3 world_min = glm::vec3(0.0f);
+    glm::vec3 world_max = glm::vec3(0.0f);
+};
+
+// The light position follows the entity's Transform.
+struct LightComponent {
+    Light light = {};
+};
+
+#endif  // SRC_COMPONENTS_H_
@@ -0,0 +1,214 @@
+#include "Culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOFU_CULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr float MIN_CLIP_W = 1e-4f;
+
+}  // namespace
+
+Frustum::Frustum(const glm::mat4& model_view_projection) {
+    const glm::mat4& m = model_view_projection;
+    for (int i = 0; i < 3; i++) {
+        for (int side = 0; side < 2; side++) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            planes_[i * 2 + side] = glm::vec4(m[0][3] + sign * m[0][i], m[1][3] + sign * m[1][i],
+                m[2][3] + sign * m[2][i], m[3][3] + sign * m[3][i]);
+        }
+    }
+}
+
+bool Frustum::Intersects(const glm::vec3& bounds_min, const glm::vec3& bounds_max) const {
+    for (const glm::vec4& plane : planes_) {
+        // the corner furthest along the plane normal decides
+        float x = plane.x >= 0.0f ? bounds_max.x : bounds_min.x;
+        float y = plane.y >= 0.0f ? bounds_max.y : bounds_min.y;
+        float z = plane.z >= 0.0f ? bounds_max.z : bounds_min.z;
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+OcclusionBuffer::OcclusionBuffer() : depth_(static_cast<size_t>(WIDTH) * HEIGHT, 0.0f) {
+}
+
+void OcclusionBuffer::Clear() {
+    std::fill(depth_.begin(), depth_.end(), 0.0f);
+}
+
+void OcclusionBuffer::RasterizeTriangles(const glm::mat4& model_view_projection,
+    const float* positions, size_t stride, size_t vertex_num, const unsigned int* indices,
+    size_t index_num) {
+    // x and y in buffer pixels, z holds 1/w; vertices behind the near plane get w = 0
+    screen_vertices_.resize(vertex_num);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(positions);
+    for (size_t i = 0; i < vertex_num; i++) {
+        const float* p = reinterpret_cast<const float*>(bytes + i * stride);
+        glm::vec4 clip = model_view_projection * glm::vec4(p[0], p[1], p[2], 1.0f);
+        if (clip.w < MIN_CLIP_W) {
+            screen_vertices_[i] = glm::vec3(0.0f);
+            continue;
+        }
+        float inv_w = 1.0f / clip.w;
+        screen_vertices_[i] = glm::vec3((clip.x * inv_w * 0.5f + 0.5f) * WIDTH,
+            (clip.y * inv_w * 0.5f + 0.5f) * HEIGHT, inv_w);
+    }
+    for (size_t i = 0; i + 2 < index_num; i += 3) {
+        const glm::vec3& v0 = screen_vertices_[indices[i]];
+        const glm::vec3& v1 = screen_vertices_[indices[i + 1]];
+        const glm::vec3& v2 = screen_vertices_[indices[i + 2]];
+        // skipping a clipped occluder triangle only makes culling less aggressive
+        if (v0.z == 0.0f || v1.z == 0.0f || v2.z == 0.0f) {
+            continue;
+        }
+        RasterizeTriangle(v0, v1, v2);
+    }
+}
+
+void OcclusionBuffer::RasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1,
+    const glm::vec3& v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    // back faces are hidden by the front faces of the same closed occluder
+    if (area <= 0.0f) {
+        return;
+    }
+    int min_x = std::max(static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))), 0);
+    int max_x = std::min(static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))), WIDTH - 1);
+    int min_y = std::max(static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))), 0);
+    int max_y = std::min(static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))),
+        HEIGHT - 1);
+    if (min_x > max_x || min_y > max_y) {
+        return;
+    }
+    min_x &= ~3;
+
+    // edge functions e = a * x + b * y + c, positive inside for counter clockwise triangles
+    float inv_area = 1.0f / area;
+    float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v2.x * v1.y;
+    float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v0.x * v2.y;
+    float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v1.x * v0.y;
+    // 1/w as a plane over the screen, from the barycentric weights
+    float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inv_area;
+    float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inv_area;
+    float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * inv_area;
+
+#ifdef MOFU_CULLING_SSE2
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+    for (int y = min_y; y <= max_y; y++) {
+        float py = y + 0.5f;
+        float* row = &depth_[static_cast<size_t>(y) * WIDTH];
+        for (int x = min_x; x <= max_x; x += 4) {
+#ifdef MOFU_CULLING_SSE2
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(b0 * py + c0));
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(b1 * py + c1));
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(b2 * py + c2));
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zb * py + zc));
+            __m128 old_z = _mm_loadu_ps(row + x);
+            __m128 new_z = _mm_max_ps(old_z, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_z),
+                _mm_andnot_ps(inside, old_z)));
+#else
+            // WIDTH is a multiple of four, so the last step of a row stays inside the row
+            for (int i = 0; i < 4; i++) {
+                float px = x + (i + 0.5f);
+                if (a0 * px + (b0 * py + c0) >= 0.0f && a1 * px + (b1 * py + c1) >= 0.0f &&
+                    a2 * px + (b2 * py + c2) >= 0.0f) {
+                    row[x + i] = std::max(row[x + i], za * px + (zb * py + zc));
+                }
+            }
+#endif
+        }
+    }
+}
+
+bool OcclusionBuffer::ProjectBox(const glm::mat4& model_view_projection,
+    const glm::vec3& bounds_min, const glm::vec3& bounds_max, ScreenRect& rect) const {
+    rect.min_x = static_cast<float>(WIDTH);
+    rect.min_y = static_cast<float>(HEIGHT);
+    rect.max_x = 0.0f;
+    rect.max_y = 0.0f;
+    rect.nearest = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 corner((i & 1) ? bounds_max.x : bounds_min.x,
+            (i & 2) ? bounds_max.y : bounds_min.y, (i & 4) ? bounds_max.z : bounds_min.z, 1.0f);
+        glm::vec4 clip = model_view_projection * corner;
+        if (clip.w < MIN_CLIP_W) {
+            return false;
+        }
+        float inv_w = 1.0f / clip.w;
+        float x = (clip.x * inv_w * 0.5f + 0.5f) * WIDTH;
+        float y = (clip.y * inv_w * 0.5f + 0.5f) * HEIGHT;
+        rect.min_x = std::min(rect.min_x, x);
+        rect.min_y = std::min(rect.min_y, y);
+        rect.max_x = std::max(rect.max_x, x);
+        rect.max_y = std::max(rect.max_y, y);
+        rect.nearest = std::max(rect.nearest, inv_w);
+    }
+    return true;
+}
+
+bool OcclusionBuffer::IsVisible(const glm::mat4& model_view_projection,
+    const glm::vec3& bounds_min, const glm::vec3& bounds_max) const {
+    ScreenRect rect;
+    if (!ProjectBox(model_view_projection, bounds_min, bounds_max, rect)) {
+        return true;
+    }
+    int min_x = std::max(static_cast<int>(std::floor(rect.min_x)), 0) & ~3;
+    int max_x = std::min(static_cast<int>(std::floor(rect.max_x)), WIDTH - 1);
+    int min_y = std::max(static_cast<int>(std::floor(rect.min_y)), 0);
+    int max_y = std::min(static_cast<int>(std::floor(rect.max_y)), HEIGHT - 1);
+    if (min_x > max_x || min_y > max_y) {
+        // off screen, that is the frustum test's call
+        return true;
+    }
+
+    // visible as soon as one pixel has no occluder nearer than the nearest point of the box
+#ifdef MOFU_CULLING_SSE2
+    const __m128 nearest = _mm_set1_ps(rect.nearest);
+#endif
+    for (int y = min_y; y <= max_y; y++) {
+        const float* row = &depth_[static_cast<size_t>(y) * WIDTH];
+        for (int x = min_x; x <= max_x; x += 4) {
+#ifdef MOFU_CULLING_SSE2
+            if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(row + x), nearest)) != 0) {
+                return true;
+            }
+#else
+            if (row[x] <= rect.nearest || row[x + 1] <= rect.nearest ||
+                row[x + 2] <= rect.nearest || row[x + 3] <= rect.nearest) {
+                return true;
+            }
+#endif
+        }
+    }
+    return false;
+}
+
+float OcclusionBuffer::ScreenArea(const glm::mat4& model_view_projection,
+    const glm::vec3& bounds_min, const glm::vec3& bounds_max) const {
+    ScreenRect rect;
+    if (!ProjectBox(model_view_projection, bounds_min, bounds_max, rect)) {
+        return 0.0f;
+    }
+    float width = std::min(rect.max_x, static_cast<float>(WIDTH)) - std::max(rect.min_x, 0.0f);
+    float height = std::min(rect.max_y, static_cast<float>(HEIGHT)) -
+        std::max(rect.min_y, 0.0f);
+    return width > 0.0f && height > 0.0f ? width * height : 0.0f;
+}
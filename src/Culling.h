@@ -0,0 +1,68 @@
+#ifndef SRC_CULLING_H_
+#define SRC_CULLING_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Clip planes taken from a model-view-projection matrix, so boxes are tested in model space.
+class Frustum {
+public:
+    explicit Frustum(const glm::mat4& model_view_projection);
+    ~Frustum() = default;
+
+    bool Intersects(const glm::vec3& bounds_min, const glm::vec3& bounds_max) const;
+
+private:
+    glm::vec4 planes_[6];
+};
+
+// A mesh that may be rasterized into an OcclusionBuffer. owner identifies the instance whose
+// transform places it; occluders are picked by screen area across all instances of a frame.
+struct OccluderCandidate {
+    float screen_area;
+    unsigned int owner;
+    unsigned int mesh;
+};
+
+// Small CPU depth buffer for occlusion culling. A few large occluders are rasterized four pixels
+// per step (with SSE2 where available), then the screen rectangle of each candidate box is
+// compared against it. The buffer stores 1/w, which is linear in screen space, and larger
+// values are nearer.
+// Works without a GPU and never reads back GL depth.
+class OcclusionBuffer {
+public:
+    OcclusionBuffer();
+    ~OcclusionBuffer() = default;
+
+    void Clear();
+    void RasterizeTriangles(const glm::mat4& model_view_projection, const float* positions,
+        size_t stride, size_t vertex_num, const unsigned int* indices, size_t index_num);
+    bool IsVisible(const glm::mat4& model_view_projection, const glm::vec3& bounds_min,
+        const glm::vec3& bounds_max) const;
+    float ScreenArea(const glm::mat4& model_view_projection, const glm::vec3& bounds_min,
+        const glm::vec3& bounds_max) const;
+
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 192;
+
+private:
+    struct ScreenRect {
+        float min_x;
+        float min_y;
+        float max_x;
+        float max_y;
+        float nearest;
+    };
+
+    // false when the box crosses the near plane and has no usable screen rectangle
+    bool ProjectBox(const glm::mat4& model_view_projection, const glm::vec3& bounds_min,
+        const glm::vec3& bounds_max, ScreenRect& rect) const;
+    void RasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+
+    std::vector<float> depth_ = {};
+    std::vector<glm::vec3> screen_vertices_ = {};
+};
+
+#endif  // SRC_CULLING_H_
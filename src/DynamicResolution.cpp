@@ -0,0 +1,101 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <GL/glew.h>
+
+namespace {
+
+constexpr float SCALE_DOWN_RATE = 0.3f;
+constexpr float SCALE_UP_RATE = 0.05f;
+// the render size follows the scale in steps of this, so it does not flicker by single pixels
+constexpr float SCALE_STEP = 1.0f / 64.0f;
+
+}  // namespace
+
+DynamicResolution::~DynamicResolution() {
+    if (queries_[0] != 0) {
+        glDeleteQueries(QUERY_NUM, queries_);
+    }
+}
+
+void DynamicResolution::SetTargetMilliseconds(double target_ms) {
+    target_ms_ = target_ms;
+    if (target_ms_ <= 0.0) {
+        scale_ = max_scale_;
+    }
+}
+
+void DynamicResolution::SetScaleRange(float min_scale, float max_scale) {
+    // the render target is window sized, so there is no supersampling
+    max_scale_ = std::min(max_scale, 1.0f);
+    min_scale_ = std::min(min_scale, max_scale_);
+    scale_ = std::min(std::max(scale_, min_scale_), max_scale_);
+}
+
+void DynamicResolution::Begin() {
+    // taken before collecting, which may already move the scale for the next frame
+    float frame_scale = QuantizedScale();
+    if (queries_[0] == 0) {
+        glGenQueries(QUERY_NUM, queries_);
+    }
+    if (pending_[current_]) {
+        Collect(current_, true);
+    }
+    query_scales_[current_] = frame_scale;
+    glBeginQuery(GL_TIME_ELAPSED, queries_[current_]);
+}
+
+void DynamicResolution::End() {
+    glEndQuery(GL_TIME_ELAPSED);
+    pending_[current_] = true;
+    current_ = (current_ + 1) % QUERY_NUM;
+    // oldest first, so the controller sees the frames in order
+    for (int i = 0; i < QUERY_NUM; i++) {
+        int query = (current_ + i) % QUERY_NUM;
+        if (pending_[query]) {
+            Collect(query, false);
+        }
+    }
+}
+
+int DynamicResolution::ScaledSize(int size) const {
+    return std::max(1, static_cast<int>(std::lround(size * QuantizedScale())));
+}
+
+float DynamicResolution::QuantizedScale() const {
+    return std::min(std::round(scale_ / SCALE_STEP) * SCALE_STEP, max_scale_);
+}
+
+void DynamicResolution::Collect(int query, bool wait) {
+    if (!wait) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries_[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            return;
+        }
+    }
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(queries_[query], GL_QUERY_RESULT, &nanoseconds);
+    pending_[query] = false;
+    double gpu_ms = nanoseconds / 1e6;
+    gpu_ms_sum_ += gpu_ms;
+    scale_sum_ += query_scales_[query];
+    resolved_num_++;
+    Adjust(gpu_ms, query_scales_[query]);
+}
+
+void DynamicResolution::Adjust(double gpu_ms, float frame_scale) {
+    if (target_ms_ <= 0.0) {
+        return;
+    }
+    // the scene is mostly fill bound, so its cost follows the pixel count, i.e. scale squared;
+    // the time belongs to the frame's own scale, which may be a few adjustments old
+    float wanted = frame_scale *
+        static_cast<float>(std::sqrt(target_ms_ / std::max(gpu_ms, 0.01)));
+    wanted = std::min(std::max(wanted, min_scale_), max_scale_);
+    float rate = wanted < scale_ ? SCALE_DOWN_RATE : SCALE_UP_RATE;
+    scale_ += (wanted - scale_) * rate;
+    lowest_scale_ = std::min(lowest_scale_, scale_);
+}
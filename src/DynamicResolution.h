@@ -0,0 +1,70 @@
+#ifndef SRC_DYNAMICRESOLUTION_H_
+#define SRC_DYNAMICRESOLUTION_H_
+
+#include <cstdint>
+
+// Picks the render resolution scale that keeps the GPU time of the scene near a target. Begin
+// and End wrap the resolution dependent passes with GL_TIME_ELAPSED queries from a small ring;
+// results arrive a few frames late, so each query keeps the scale its frame was drawn at and
+// the correction is computed against that. Each result nudges the scale, quickly down when over
+// budget and slowly back up when there is headroom so it does not oscillate. A target of 0
+// keeps the maximum scale.
+class DynamicResolution {
+public:
+    DynamicResolution() = default;
+    ~DynamicResolution();
+
+    void SetTargetMilliseconds(double target_ms);
+    void SetScaleRange(float min_scale, float max_scale);
+    // the frame is assumed to be drawn at the ScaledSize in effect when Begin is called
+    void Begin();
+    void End();
+    int ScaledSize(int size) const;
+    inline float Scale() const;
+    inline uint64_t ResolvedNum() const;
+    inline double AverageGpuMilliseconds() const;
+    inline double AverageScale() const;
+    inline float LowestScale() const;
+
+    static constexpr int QUERY_NUM = 4;
+
+private:
+    void Collect(int query, bool wait);
+    void Adjust(double gpu_ms, float frame_scale);
+    float QuantizedScale() const;
+
+    unsigned int queries_[QUERY_NUM] = {};
+    bool pending_[QUERY_NUM] = {};
+    float query_scales_[QUERY_NUM] = {};
+    int current_ = 0;
+    double target_ms_ = 0.0;
+    float min_scale_ = 0.5f;
+    float max_scale_ = 1.0f;
+    float scale_ = 1.0f;
+    float lowest_scale_ = 1.0f;
+    uint64_t resolved_num_ = 0;
+    double gpu_ms_sum_ = 0.0;
+    double scale_sum_ = 0.0;
+};
+
+float DynamicResolution::Scale() const {
+    return scale_;
+}
+
+uint64_t DynamicResolution::ResolvedNum() const {
+    return resolved_num_;
+}
+
+double DynamicResolution::AverageGpuMilliseconds() const {
+    return resolved_num_ > 0 ? gpu_ms_sum_ / resolved_num_ : 0.0;
+}
+
+double DynamicResolution::AverageScale() const {
+    return resolved_num_ > 0 ? scale_sum_ / resolved_num_ : scale_;
+}
+
+float DynamicResolution::LowestScale() const {
+    return lowest_scale_;
+}
+
+#endif  // SRC_DYNAMICRESOLUTION_H_
@@ -0,0 +1,44 @@
+#ifndef SRC_FRAMESNAPSHOT_H_
+#define SRC_FRAMESNAPSHOT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "LightManager.h"
+
+// World box in which static geometry was added or removed.
+struct StaticChange {
+    glm::vec3 bounds_min = glm::vec3(0.0f);
+    glm::vec3 bounds_max = glm::vec3(0.0f);
+};
+
+// Everything the renderer needs for one frame, produced by the update loop. Once published the
+// snapshot is immutable; the render side only reads it.
+struct FrameSnapshot {
+    static constexpr int STATIC_CHANGE_NUM = 8;
+
+    uint64_t frame_index = 0;
+    std::chrono::steady_clock::time_point input_time = {};
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 view_pos = glm::vec3(0.0f);
+    // window framebuffer size, 0 while minimized
+    int screen_width = 0;
+    int screen_height = 0;
+    // one entry per rendered entity, visible_instances indexes the ones inside the view frustum
+    std::vector<glm::mat4> instance_transforms = {};
+    std::vector<unsigned int> instance_models = {};
+    std::vector<unsigned char> instance_casts_shadows = {};
+    std::vector<unsigned char> instance_static = {};
+    std::vector<unsigned int> visible_instances = {};
+    std::vector<Light> lights = {};
+    // static geometry changes are numbered; the last STATIC_CHANGE_NUM of them are kept by
+    // revision % STATIC_CHANGE_NUM, so a renderer that skipped snapshots can still catch up
+    uint64_t static_revision = 0;
+    StaticChange static_changes[STATIC_CHANGE_NUM] = {};
+};
+
+#endif  // SRC_FRAMESNAPSHOT_H_
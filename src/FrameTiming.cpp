@@ -0,0 +1,79 @@
+#include "FrameTiming.h"
+
+#include <thread>
+
+namespace {
+
+template <typename Duration>
+Duration FromSeconds(double seconds) {
+    return std::chrono::duration_cast<Duration>(std::chrono::duration<double>(seconds));
+}
+
+}  // namespace
+
+FixedTimestep::FixedTimestep(double tick_seconds, int max_ticks_per_frame) :
+    tick_(FromSeconds<Clock::duration>(tick_seconds)), max_ticks_per_frame_(max_ticks_per_frame) {
+    Reset();
+}
+
+void FixedTimestep::Reset() {
+    accumulator_ = Clock::duration::zero();
+    last_time_ = Clock::now();
+}
+
+int FixedTimestep::Advance() {
+    Clock::time_point now = Clock::now();
+    accumulator_ += now - last_time_;
+    last_time_ = now;
+
+    int ticks = 0;
+    while (accumulator_ >= tick_ && ticks < max_ticks_per_frame_) {
+        accumulator_ -= tick_;
+        ticks++;
+    }
+    // after a long stall drop the backlog instead of spiralling through catch-up ticks
+    if (accumulator_ >= tick_) {
+        accumulator_ = accumulator_ % tick_;
+    }
+    return ticks;
+}
+
+FramePacer::FramePacer(double target_fps, double spin_seconds) {
+    SetTargetFps(target_fps);
+    SetSpinSeconds(spin_seconds);
+}
+
+void FramePacer::SetTargetFps(double target_fps) {
+    period_ = target_fps > 0.0 ? FromSeconds<Clock::duration>(1.0 / target_fps) :
+        Clock::duration::zero();
+    started_ = false;
+}
+
+void FramePacer::SetSpinSeconds(double spin_seconds) {
+    spin_ = FromSeconds<Clock::duration>(spin_seconds > 0.0 ? spin_seconds : 0.0);
+}
+
+void FramePacer::Wait() {
+    if (!started_) {
+        last_frame_ = Clock::now();
+        deadline_ = last_frame_;
+        started_ = true;
+    }
+    if (Enabled()) {
+        deadline_ += period_;
+        Clock::time_point now = Clock::now();
+        if (now > deadline_ + period_) {
+            // too far behind, restart the schedule rather than rushing frames out
+            deadline_ = now;
+        }
+        if (deadline_ - now > spin_) {
+            std::this_thread::sleep_until(deadline_ - spin_);
+        }
+        while (Clock::now() < deadline_) {
+            std::this_thread::yield();
+        }
+    }
+    Clock::time_point now = Clock::now();
+    frame_seconds_ = std::chrono::duration<double>(now - last_frame_).count();
+    last_frame_ = now;
+}
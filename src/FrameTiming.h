@@ -0,0 +1,70 @@
+#ifndef SRC_FRAMETIMING_H_
+#define SRC_FRAMETIMING_H_
+
+#include <chrono>
+
+// Accumulates real time on a monotonic clock and hands it out as whole simulation ticks of a
+// fixed length. Alpha() is the fraction of a tick left over, used to blend render state between
+// the previous and the current tick.
+class FixedTimestep {
+public:
+    explicit FixedTimestep(double tick_seconds = 1.0 / 120.0, int max_ticks_per_frame = 8);
+    ~FixedTimestep() = default;
+
+    void Reset();
+    int Advance();
+    inline float TickSeconds() const;
+    inline float Alpha() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration tick_ = {};
+    Clock::duration accumulator_ = {};
+    Clock::time_point last_time_ = {};
+    int max_ticks_per_frame_ = 8;
+};
+
+// Holds frames to a target period. Most of the wait is spent sleeping, only the last
+// spin_seconds are spent yielding in a loop, since OS sleeps routinely overshoot by a millisecond
+// or more. A target of 0 disables pacing.
+class FramePacer {
+public:
+    explicit FramePacer(double target_fps = 0.0, double spin_seconds = 0.002);
+    ~FramePacer() = default;
+
+    void SetTargetFps(double target_fps);
+    void SetSpinSeconds(double spin_seconds);
+    void Wait();
+    inline bool Enabled() const;
+    inline double FrameSeconds() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration period_ = {};
+    Clock::duration spin_ = {};
+    Clock::time_point deadline_ = {};
+    Clock::time_point last_frame_ = {};
+    double frame_seconds_ = 0.0;
+    bool started_ = false;
+};
+
+float FixedTimestep::TickSeconds() const {
+    return std::chrono::duration<float>(tick_).count();
+}
+
+float FixedTimestep::Alpha() const {
+    return std::chrono::duration<float>(accumulator_).count() /
+        std::chrono::duration<float>(tick_).count();
+}
+
+bool FramePacer::Enabled() const {
+    return period_.count() > 0;
+}
+
+double FramePacer::FrameSeconds() const {
+    return frame_seconds_;
+}
+
+#endif  // SRC_FRAMETIMING_H_
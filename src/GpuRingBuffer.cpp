@@ -0,0 +1,137 @@
+#include "GpuRingBuffer.h"
+
+#include <chrono>
+#include <iostream>
+
+#include <GL/glew.h>
+
+namespace {
+
+constexpr size_t REGION_ALIGNMENT = 256;
+constexpr GLuint64 WAIT_TIMEOUT_NS = 1000000;
+
+size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+GpuRingBuffer::~GpuRingBuffer() {
+    if (buffer_ == 0) {
+        return;
+    }
+    for (void*& fence : fences_) {
+        if (fence != nullptr) {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+    if (persistent_) {
+        glBindBuffer(target_, buffer_);
+        glUnmapBuffer(target_);
+        glBindBuffer(target_, 0);
+    }
+    glDeleteBuffers(1, &buffer_);
+}
+
+bool GpuRingBuffer::Init(unsigned int target, size_t region_size) {
+    target_ = target;
+    region_size_ = AlignUp(region_size, REGION_ALIGNMENT);
+    persistent_ = GLEW_ARB_buffer_storage;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(target_, buffer_);
+    if (persistent_) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr total_size = static_cast<GLsizeiptr>(region_size_ * REGION_NUM);
+        glBufferStorage(target_, total_size, nullptr, flags);
+        mapped_ = static_cast<char*>(glMapBufferRange(target_, 0, total_size, flags));
+        if (mapped_ == nullptr) {
+            std::cout << "ERROR::RING_BUFFER::MAP_FAILED" << std::endl;
+            glBindBuffer(target_, 0);
+            glDeleteBuffers(1, &buffer_);
+            buffer_ = 0;
+            return false;
+        }
+    } else {
+        glBufferData(target_, static_cast<GLsizeiptr>(region_size_), nullptr, GL_STREAM_DRAW);
+        staging_.resize(region_size_);
+    }
+    glBindBuffer(target_, 0);
+    return true;
+}
+
+void GpuRingBuffer::BeginFrame() {
+    head_ = 0;
+    flushed_ = 0;
+    if (buffer_ == 0) {
+        return;
+    }
+    if (persistent_) {
+        WaitRegion(region_);
+    } else {
+        // orphaning hands the driver a fresh store while draws of the last frame keep the old one
+        glBindBuffer(target_, buffer_);
+        glBufferData(target_, static_cast<GLsizeiptr>(region_size_), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(target_, 0);
+    }
+}
+
+RingAllocation GpuRingBuffer::Allocate(size_t size, size_t alignment) {
+    RingAllocation allocation;
+    size_t base = persistent_ ? region_ * region_size_ : 0;
+    size_t offset = AlignUp(base + head_, alignment > 0 ? alignment : 1);
+    if (buffer_ == 0 || offset + size > base + region_size_) {
+        overflow_num_++;
+        return allocation;
+    }
+    head_ = offset + size - base;
+    if (head_ > peak_usage_) {
+        peak_usage_ = head_;
+    }
+    allocation.data = persistent_ ? mapped_ + offset : staging_.data() + offset;
+    allocation.buffer = buffer_;
+    allocation.offset = offset;
+    allocation.size = size;
+    return allocation;
+}
+
+void GpuRingBuffer::Flush() {
+    // the persistent mapping is coherent, writes are seen by every later command
+    if (persistent_ || head_ == flushed_) {
+        return;
+    }
+    glBindBuffer(target_, buffer_);
+    glBufferSubData(target_, static_cast<GLintptr>(flushed_),
+        static_cast<GLsizeiptr>(head_ - flushed_), staging_.data() + flushed_);
+    glBindBuffer(target_, 0);
+    flushed_ = head_;
+}
+
+void GpuRingBuffer::EndFrame() {
+    Flush();
+    if (persistent_ && buffer_ != 0) {
+        fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region_ = (region_ + 1) % REGION_NUM;
+    }
+    frame_num_++;
+}
+
+void GpuRingBuffer::WaitRegion(int region) {
+    GLsync fence = static_cast<GLsync>(fences_[region]);
+    if (fence == nullptr) {
+        return;
+    }
+    // with REGION_NUM frames in flight this is normally signaled long ago
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        stall_num_++;
+        auto start = std::chrono::steady_clock::now();
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        stall_milliseconds_ += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(fence);
+    fences_[region] = nullptr;
+}
@@ -0,0 +1,100 @@
+#ifndef SRC_GPURINGBUFFER_H_
+#define SRC_GPURINGBUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RingAllocation {
+    void* data = nullptr;
+    unsigned int buffer = 0;
+    size_t offset = 0;
+    size_t size = 0;
+
+    inline bool Valid() const;
+};
+
+// Streaming upload path for data that changes every frame. One buffer is split into REGION_NUM
+// per-frame regions; with ARB_buffer_storage it stays persistently mapped and the CPU writes
+// straight into GPU visible memory, a fence per region tells when the GPU is done reading it.
+// Without the extension allocations go to a CPU staging copy that Flush uploads with
+// glBufferSubData into a buffer orphaned every frame, so no draw ever waits on an old one.
+class GpuRingBuffer {
+public:
+    GpuRingBuffer() = default;
+    ~GpuRingBuffer();
+    GpuRingBuffer(const GpuRingBuffer&) = delete;
+    GpuRingBuffer& operator=(const GpuRingBuffer&) = delete;
+
+    bool Init(unsigned int target, size_t region_size);
+    void BeginFrame();
+    // the returned memory is only valid until EndFrame; an invalid allocation means the region
+    // is full for this frame
+    RingAllocation Allocate(size_t size, size_t alignment);
+    // makes everything allocated so far visible to the GPU, call before drawing with it
+    void Flush();
+    void EndFrame();
+
+    inline bool Persistent() const;
+    inline uint64_t FrameNum() const;
+    inline uint64_t StallNum() const;
+    inline double StallMilliseconds() const;
+    inline uint64_t OverflowNum() const;
+    inline size_t PeakUsage() const;
+    inline size_t RegionSize() const;
+
+    static constexpr int REGION_NUM = 3;
+
+private:
+    void WaitRegion(int region);
+
+    unsigned int target_ = 0;
+    unsigned int buffer_ = 0;
+    bool persistent_ = false;
+    char* mapped_ = nullptr;
+    std::vector<char> staging_ = {};
+    void* fences_[REGION_NUM] = {};
+    size_t region_size_ = 0;
+    int region_ = 0;
+    size_t head_ = 0;
+    size_t flushed_ = 0;
+    uint64_t frame_num_ = 0;
+    uint64_t stall_num_ = 0;
+    double stall_milliseconds_ = 0.0;
+    uint64_t overflow_num_ = 0;
+    size_t peak_usage_ = 0;
+};
+
+bool RingAllocation::Valid() const {
+    return data != nullptr;
+}
+
+bool GpuRingBuffer::Persistent() const {
+    return persistent_;
+}
+
+uint64_t GpuRingBuffer::FrameNum() const {
+    return frame_num_;
+}
+
+uint64_t GpuRingBuffer::StallNum() const {
+    return stall_num_;
+}
+
+double GpuRingBuffer::StallMilliseconds() const {
+    return stall_milliseconds_;
+}
+
+uint64_t GpuRingBuffer::OverflowNum() const {
+    return overflow_num_;
+}
+
+size_t GpuRingBuffer::PeakUsage() const {
+    return peak_usage_;
+}
+
+size_t GpuRingBuffer::RegionSize() const {
+    return region_size_;
+}
+
+#endif  // SRC_GPURINGBUFFER_H_
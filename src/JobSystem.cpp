@@ -0,0 +1,235 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+thread_local JobSystem* JobSystem::current_system_ = nullptr;
+thread_local unsigned int JobSystem::current_index_ = 0;
+
+bool WorkStealingQueue::Push(Job* job) {
+    long long bottom = bottom_.load(std::memory_order_relaxed);
+    long long top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<long long>(CAPACITY)) {
+        return false;
+    }
+    jobs_[bottom & MASK].store(job, std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingQueue::Pop() {
+    long long bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = jobs_[bottom & MASK].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // last element, race against thieves for it
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+            std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingQueue::Steal() {
+    long long top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    Job* job = jobs_[top & MASK].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+        std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+Job* JobRing::Acquire() {
+    Job& job = slots_[next_ & MASK];
+    if (job.busy.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    job.busy.store(true, std::memory_order_relaxed);
+    next_++;
+    return &job;
+}
+
+JobSystem::JobSystem(unsigned int worker_num) {
+    worker_num_ = std::max(worker_num, 1u);
+    for (unsigned int i = 0; i < worker_num_; i++) {
+        queues_.emplace_back(new WorkStealingQueue());
+    }
+    for (unsigned int i = 0; i <= worker_num_; i++) {
+        rings_.emplace_back(new JobRing());
+    }
+    current_system_ = this;
+    current_index_ = 0;
+    for (unsigned int i = 1; i < worker_num_; i++) {
+        threads_.emplace_back([this, i]() {
+            WorkerLoop(i);
+        });
+    }
+}
+
+JobSystem::~JobSystem() {
+    stop_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    sleep_cv_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+    while (RunOne(0)) {
+    }
+    if (current_system_ == this) {
+        current_system_ = nullptr;
+    }
+}
+
+Job* JobSystem::AcquireJob(unsigned int index) {
+    if (index < worker_num_) {
+        return rings_[index]->Acquire();
+    }
+    std::lock_guard<std::mutex> lock(inject_mutex_);
+    return rings_[worker_num_]->Acquire();
+}
+
+void JobSystem::Submit(Job* job, unsigned int index) {
+    if (index < worker_num_) {
+        if (!queues_[index]->Push(job)) {
+            Execute(job);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        inject_queue_.push_back(job);
+        inject_num_.fetch_add(1);
+    }
+    queued_num_.fetch_add(1);
+    if (sleeping_num_.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        sleep_cv_.notify_one();
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    unsigned int index = CurrentIndex();
+    while (!counter.Done()) {
+        if (!RunOne(index)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain,
+    const std::function<void(size_t begin, size_t end)>& func) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max(grain, static_cast<size_t>(1));
+    if (worker_num_ == 1 || count <= grain) {
+        func(0, count);
+        return;
+    }
+    JobCounter counter;
+    for (size_t begin = grain; begin < count; begin += grain) {
+        size_t end = std::min(begin + grain, count);
+        Run([&func, begin, end]() {
+            func(begin, end);
+        }, &counter);
+    }
+    func(0, grain);
+    Wait(counter);
+}
+
+void JobSystem::WorkerLoop(unsigned int index) {
+    current_system_ = this;
+    current_index_ = index;
+    static constexpr int SPIN_COUNT = 64;
+    int idle = 0;
+    while (!stop_.load(std::memory_order_relaxed)) {
+        if (RunOne(index)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleeping_num_.fetch_add(1);
+        sleep_cv_.wait(lock, [this]() {
+            return stop_.load() || queued_num_.load() > 0;
+        });
+        sleeping_num_.fetch_sub(1);
+        idle = 0;
+    }
+}
+
+bool JobSystem::RunOne(unsigned int index) {
+    Job* job = FindJob(index);
+    if (!job) {
+        return false;
+    }
+    Execute(job);
+    return true;
+}
+
+Job* JobSystem::FindJob(unsigned int index) {
+    if (queued_num_.load(std::memory_order_relaxed) <= 0) {
+        return nullptr;
+    }
+    Job* job = nullptr;
+    if (index < worker_num_) {
+        job = queues_[index]->Pop();
+    }
+    if (!job && inject_num_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (!inject_queue_.empty()) {
+            job = inject_queue_.front();
+            inject_queue_.pop_front();
+            inject_num_.fetch_sub(1);
+        }
+    }
+    if (!job) {
+        static thread_local unsigned int seed = 2463534242u;
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        unsigned int start = seed % worker_num_;
+        for (unsigned int i = 0; i < worker_num_ && !job; i++) {
+            unsigned int victim = (start + i) % worker_num_;
+            if (victim != index) {
+                job = queues_[victim]->Steal();
+            }
+        }
+    }
+    if (job) {
+        queued_num_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void JobSystem::Execute(Job* job) {
+    JobCounter* counter = job->counter;
+    job->invoke(*job);
+    job->busy.store(false, std::memory_order_release);
+    if (counter) {
+        counter->pending_.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+unsigned int JobSystem::CurrentIndex() const {
+    return current_system_ == this ? current_index_ : worker_num_;
+}
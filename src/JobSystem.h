@@ -0,0 +1,168 @@
+#ifndef SRC_JOBSYSTEM_H_
+#define SRC_JOBSYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobCounter {
+public:
+    JobCounter() = default;
+    ~JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    inline bool Done() const;
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> pending_{0};
+};
+
+// The callable is stored in place, so a job never allocates. Invoke runs and destroys it.
+struct Job {
+    static constexpr size_t STORAGE_SIZE = 64;
+
+    typename std::aligned_storage<STORAGE_SIZE, alignof(std::max_align_t)>::type storage;
+    void (*invoke)(Job& job) = nullptr;
+    JobCounter* counter = nullptr;
+    // set while the job is queued or running, the slot is reused only once it is cleared
+    std::atomic<bool> busy{false};
+};
+
+// Chase-Lev deque: the owning thread pushes and pops at the bottom, other threads steal from the
+// top. The capacity is fixed; Push() fails when full and the caller runs the job inline.
+class WorkStealingQueue {
+public:
+    WorkStealingQueue() = default;
+    ~WorkStealingQueue() = default;
+
+    bool Push(Job* job);
+    Job* Pop();
+    Job* Steal();
+
+    static constexpr size_t CAPACITY = 4096;
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    // keep the thieves' index and the owner's index on separate cache lines
+    std::atomic<long long> top_{0};
+    char top_padding_[64 - sizeof(std::atomic<long long>)] = {};
+    std::atomic<long long> bottom_{0};
+    char bottom_padding_[64 - sizeof(std::atomic<long long>)] = {};
+    std::atomic<Job*> jobs_[CAPACITY] = {};
+};
+
+// Fixed ring of job slots owned by one submitting thread. Jobs finish roughly in submission
+// order, so only the next slot is checked; if it is still busy Acquire() fails and the caller
+// runs the job inline, just like a full queue.
+class JobRing {
+public:
+    JobRing() = default;
+    ~JobRing() = default;
+    JobRing(const JobRing&) = delete;
+    JobRing& operator=(const JobRing&) = delete;
+
+    Job* Acquire();
+
+    static constexpr size_t SLOT_NUM = WorkStealingQueue::CAPACITY;
+
+private:
+    static constexpr size_t MASK = SLOT_NUM - 1;
+
+    std::unique_ptr<Job[]> slots_{new Job[SLOT_NUM]};
+    size_t next_ = 0;
+};
+
+class JobSystem {
+public:
+    // worker_num counts the calling thread, so JobSystem(1) runs everything on the caller.
+    explicit JobSystem(unsigned int worker_num = std::thread::hardware_concurrency());
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    template <typename F>
+    void Run(F&& func, JobCounter* counter = nullptr);
+    void Wait(JobCounter& counter);
+    void ParallelFor(size_t count, size_t grain,
+        const std::function<void(size_t begin, size_t end)>& func);
+    inline unsigned int WorkerNum() const;
+
+private:
+    template <typename F>
+    static void Invoke(Job& job);
+    Job* AcquireJob(unsigned int index);
+    void Submit(Job* job, unsigned int index);
+    void WorkerLoop(unsigned int index);
+    bool RunOne(unsigned int index);
+    Job* FindJob(unsigned int index);
+    void Execute(Job* job);
+    unsigned int CurrentIndex() const;
+
+    unsigned int worker_num_ = 1;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> queued_num_{0};
+    std::atomic<int> sleeping_num_{0};
+    std::atomic<int> inject_num_{0};
+    std::vector<std::unique_ptr<WorkStealingQueue>> queues_ = {};
+    // one ring per worker plus a last one shared by outside threads under inject_mutex_
+    std::vector<std::unique_ptr<JobRing>> rings_ = {};
+    std::vector<std::thread> threads_ = {};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::mutex inject_mutex_;
+    std::deque<Job*> inject_queue_ = {};
+
+    static thread_local JobSystem* current_system_;
+    static thread_local unsigned int current_index_;
+};
+
+bool JobCounter::Done() const {
+    return pending_.load(std::memory_order_acquire) == 0;
+}
+
+template <typename F>
+void JobSystem::Run(F&& func, JobCounter* counter) {
+    using Callable = typename std::decay<F>::type;
+    static_assert(sizeof(Callable) <= Job::STORAGE_SIZE, "job captures do not fit a job slot");
+    static_assert(alignof(Callable) <= alignof(std::max_align_t), "job captures over-aligned");
+
+    unsigned int index = CurrentIndex();
+    Job* job = worker_num_ == 1 ? nullptr : AcquireJob(index);
+    if (!job) {
+        func();
+        return;
+    }
+    new (&job->storage) Callable(std::forward<F>(func));
+    job->invoke = &Invoke<Callable>;
+    job->counter = counter;
+    if (counter) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Submit(job, index);
+}
+
+template <typename F>
+void JobSystem::Invoke(Job& job) {
+    F& func = *reinterpret_cast<F*>(&job.storage);
+    func();
+    func.~F();
+}
+
+unsigned int JobSystem::WorkerNum() const {
+    return worker_num_;
+}
+
+#endif  // SRC_JOBSYSTEM_H_
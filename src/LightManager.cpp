@@ -0,0 +1,292 @@
+#include "LightManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <GL/glew.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOFU_LIGHT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Tests one froxel AABB against four light spheres, returns a bit per overlapping light.
+int SphereAabb4(const float* bounds_min, const float* bounds_max, const float* x,
+    const float* y, const float* z, const float* radius) {
+#ifdef MOFU_LIGHT_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    __m128 cx = _mm_loadu_ps(x);
+    __m128 cy = _mm_loadu_ps(y);
+    __m128 cz = _mm_loadu_ps(z);
+    __m128 r = _mm_loadu_ps(radius);
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bounds_min[0]), cx),
+        _mm_sub_ps(cx, _mm_set1_ps(bounds_max[0]))), zero);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bounds_min[1]), cy),
+        _mm_sub_ps(cy, _mm_set1_ps(bounds_max[1]))), zero);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bounds_min[2]), cz),
+        _mm_sub_ps(cz, _mm_set1_ps(bounds_max[2]))), zero);
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+        _mm_mul_ps(dz, dz));
+    return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(r, r)));
+#else
+    int mask = 0;
+    for (int i = 0; i < 4; i++) {
+        float dx = std::max(std::max(bounds_min[0] - x[i], x[i] - bounds_max[0]), 0.0f);
+        float dy = std::max(std::max(bounds_min[1] - y[i], y[i] - bounds_max[1]), 0.0f);
+        float dz = std::max(std::max(bounds_min[2] - z[i], z[i] - bounds_max[2]), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= radius[i] * radius[i]) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+void UploadTextureBuffer(unsigned int& buffer, unsigned int& texture, GLenum format,
+    const void* data, size_t size) {
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glGenTextures(1, &texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // orphan the previous store so the driver does not have to wait for last frame's reads
+    glBufferData(GL_TEXTURE_BUFFER, std::max(size, static_cast<size_t>(16)), nullptr,
+        GL_STREAM_DRAW);
+    if (size > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+}  // namespace
+
+size_t LightManager::AddLight(const Light& light) {
+    lights_.push_back(light);
+    return lights_.size() - 1;
+}
+
+void LightManager::SetLights(const std::vector<Light>& lights) {
+    lights_.assign(lights.begin(), lights.end());
+}
+
+void LightManager::ClearLights() {
+    lights_.clear();
+}
+
+void LightManager::SetDirectionalLight(const DirectionalLight& light) {
+    directional_light_ = light;
+}
+
+void LightManager::SetJobSystem(JobSystem* jobs) {
+    jobs_ = jobs;
+}
+
+void LightManager::Update(const glm::mat4& view, const glm::mat4& projection, float z_near,
+    float z_far, int width, int height) {
+    width_ = std::max(width, 1);
+    height_ = std::max(height, 1);
+    if (cluster_bounds_.empty() || z_near != z_near_ || z_far != z_far_ ||
+        projection[0][0] != bounds_proj_x_ || projection[1][1] != bounds_proj_y_) {
+        BuildClusterBounds(projection, z_near, z_far);
+    }
+
+    size_t light_num = lights_.size();
+    light_x_.resize(light_num);
+    light_y_.resize(light_num);
+    light_z_.resize(light_num);
+    light_radius_.resize(light_num);
+    light_slice_min_.assign(light_num, 0);
+    light_slice_max_.assign(light_num, -1);
+    light_data_.resize(light_num * 12);
+    for (size_t i = 0; i < light_num; i++) {
+        const Light& light = lights_[i];
+        glm::vec4 position = view * glm::vec4(light.position, 1.0f);
+        light_x_[i] = position.x;
+        light_y_[i] = position.y;
+        light_z_[i] = position.z;
+        light_radius_[i] = light.range;
+        float depth = -position.z;
+        if (depth + light.range >= z_near_ && depth - light.range <= z_far_) {
+            light_slice_min_[i] = SliceOf(depth - light.range);
+            light_slice_max_[i] = SliceOf(depth + light.range);
+        }
+
+        bool spot = light.type == LightType::SPOT;
+        glm::vec3 direction = glm::normalize(light.direction);
+        glm::vec3 color = light.color * light.intensity;
+        float* data = &light_data_[i * 12];
+        data[0] = light.position.x;
+        data[1] = light.position.y;
+        data[2] = light.position.z;
+        data[3] = light.range;
+        data[4] = color.x;
+        data[5] = color.y;
+        data[6] = color.z;
+        data[7] = spot ? std::cos(glm::radians(light.inner_angle)) : -1.0f;
+        data[8] = direction.x;
+        data[9] = direction.y;
+        data[10] = direction.z;
+        data[11] = spot ? std::cos(glm::radians(light.outer_angle)) : -2.0f;
+    }
+
+    slices_.resize(CLUSTER_Z);
+    auto assign = [this](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; slice++) {
+            AssignSlice(static_cast<int>(slice));
+        }
+    };
+    if (jobs_) {
+        jobs_->ParallelFor(CLUSTER_Z, 1, assign);
+    } else {
+        assign(0, CLUSTER_Z);
+    }
+
+    cluster_grid_.resize(CLUSTER_NUM * 2);
+    light_indices_.clear();
+    for (int slice = 0; slice < CLUSTER_Z; slice++) {
+        const SliceOutput& output = slices_[slice];
+        uint32_t offset = static_cast<uint32_t>(light_indices_.size());
+        for (int i = 0; i < CLUSTER_X * CLUSTER_Y; i++) {
+            int cluster = slice * CLUSTER_X * CLUSTER_Y + i;
+            cluster_grid_[cluster * 2] = offset;
+            cluster_grid_[cluster * 2 + 1] = output.counts[i];
+            offset += output.counts[i];
+        }
+        light_indices_.insert(light_indices_.end(), output.indices.begin(),
+            output.indices.end());
+    }
+}
+
+void LightManager::Upload() {
+    UploadTextureBuffer(light_data_buffer_, light_data_texture_, GL_RGBA32F, light_data_.data(),
+        light_data_.size() * sizeof(float));
+    UploadTextureBuffer(cluster_grid_buffer_, cluster_grid_texture_, GL_RG32UI,
+        cluster_grid_.data(), cluster_grid_.size() * sizeof(uint32_t));
+    UploadTextureBuffer(light_index_buffer_, light_index_texture_, GL_R32UI,
+        light_indices_.data(), light_indices_.size() * sizeof(uint32_t));
+}
+
+void LightManager::Apply(const Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + LIGHT_DATA_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, light_data_texture_);
+    glActiveTexture(GL_TEXTURE0 + CLUSTER_GRID_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, cluster_grid_texture_);
+    glActiveTexture(GL_TEXTURE0 + LIGHT_INDEX_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, light_index_texture_);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.SetInt("light_data", LIGHT_DATA_UNIT);
+    shader.SetInt("cluster_grid", CLUSTER_GRID_UNIT);
+    shader.SetInt("light_indices", LIGHT_INDEX_UNIT);
+    glUniform3i(shader.Location("cluster_dims"), CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    shader.SetVec2("cluster_tile_size", static_cast<float>(width_) / CLUSTER_X,
+        static_cast<float>(height_) / CLUSTER_Y);
+    shader.SetFloat("cluster_near", z_near_);
+    shader.SetFloat("cluster_depth_scale", CLUSTER_Z / std::log(z_far_ / z_near_));
+
+    shader.SetVec3("light.direction", directional_light_.direction);
+    shader.SetVec3("light.ambient", directional_light_.ambient);
+    shader.SetVec3("light.diffuse", directional_light_.diffuse);
+    shader.SetVec3("light.specular", directional_light_.specular);
+}
+
+void LightManager::BuildClusterBounds(const glm::mat4& projection, float z_near, float z_far) {
+    z_near_ = z_near;
+    z_far_ = z_far;
+    bounds_proj_x_ = projection[0][0];
+    bounds_proj_y_ = projection[1][1];
+    cluster_bounds_.resize(CLUSTER_NUM);
+    for (int z = 0; z < CLUSTER_Z; z++) {
+        float depth_near = z_near * std::pow(z_far / z_near, static_cast<float>(z) / CLUSTER_Z);
+        float depth_far = z_near * std::pow(z_far / z_near,
+            static_cast<float>(z + 1) / CLUSTER_Z);
+        for (int y = 0; y < CLUSTER_Y; y++) {
+            float ndc_y0 = -1.0f + 2.0f * y / CLUSTER_Y;
+            float ndc_y1 = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+            for (int x = 0; x < CLUSTER_X; x++) {
+                float ndc_x0 = -1.0f + 2.0f * x / CLUSTER_X;
+                float ndc_x1 = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+                ClusterBounds& bounds = cluster_bounds_[(z * CLUSTER_Y + y) * CLUSTER_X + x];
+                bounds.min[0] = bounds.min[1] = 1e30f;
+                bounds.max[0] = bounds.max[1] = -1e30f;
+                // the tile's view space extent at both ends of the slice
+                for (float depth : { depth_near, depth_far }) {
+                    for (float ndc_x : { ndc_x0, ndc_x1 }) {
+                        float view_x = ndc_x * depth / bounds_proj_x_;
+                        bounds.min[0] = std::min(bounds.min[0], view_x);
+                        bounds.max[0] = std::max(bounds.max[0], view_x);
+                    }
+                    for (float ndc_y : { ndc_y0, ndc_y1 }) {
+                        float view_y = ndc_y * depth / bounds_proj_y_;
+                        bounds.min[1] = std::min(bounds.min[1], view_y);
+                        bounds.max[1] = std::max(bounds.max[1], view_y);
+                    }
+                }
+                bounds.min[2] = -depth_far;
+                bounds.max[2] = -depth_near;
+            }
+        }
+    }
+}
+
+void LightManager::AssignSlice(int slice) {
+    SliceOutput& output = slices_[slice];
+    output.counts.assign(CLUSTER_X * CLUSTER_Y, 0);
+    output.indices.clear();
+    output.candidates.clear();
+    for (size_t i = 0; i < lights_.size(); i++) {
+        if (light_slice_min_[i] <= slice && slice <= light_slice_max_[i]) {
+            output.candidates.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    if (output.candidates.empty()) {
+        return;
+    }
+
+    // gather the candidates into packed SoA so the inner loop tests four at a time
+    size_t candidate_num = output.candidates.size();
+    size_t padded_num = (candidate_num + 3) & ~static_cast<size_t>(3);
+    output.packed.resize(padded_num * 4);
+    float* x = &output.packed[0];
+    float* y = x + padded_num;
+    float* z = y + padded_num;
+    float* radius = z + padded_num;
+    for (size_t i = 0; i < padded_num; i++) {
+        bool valid = i < candidate_num;
+        uint32_t light = valid ? output.candidates[i] : 0;
+        x[i] = valid ? light_x_[light] : 0.0f;
+        y[i] = valid ? light_y_[light] : 0.0f;
+        z[i] = valid ? light_z_[light] : 1e30f;
+        radius[i] = valid ? light_radius_[light] : 0.0f;
+    }
+
+    for (int i = 0; i < CLUSTER_X * CLUSTER_Y; i++) {
+        const ClusterBounds& bounds = cluster_bounds_[slice * CLUSTER_X * CLUSTER_Y + i];
+        size_t begin = output.indices.size();
+        for (size_t j = 0; j < padded_num; j += 4) {
+            int mask = SphereAabb4(bounds.min, bounds.max, x + j, y + j, z + j, radius + j);
+            for (int bit = 0; mask != 0; bit++, mask >>= 1) {
+                if (mask & 1) {
+                    output.indices.push_back(output.candidates[j + bit]);
+                }
+            }
+        }
+        output.counts[i] = static_cast<uint32_t>(output.indices.size() - begin);
+    }
+}
+
+int LightManager::SliceOf(float depth) const {
+    if (depth <= z_near_) {
+        return 0;
+    }
+    int slice = static_cast<int>(std::floor(std::log(depth / z_near_) /
+        std::log(z_far_ / z_near_) * CLUSTER_Z));
+    return std::min(std::max(slice, 0), CLUSTER_Z - 1);
+}
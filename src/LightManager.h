@@ -0,0 +1,133 @@
+#ifndef SRC_LIGHTMANAGER_H_
+#define SRC_LIGHTMANAGER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "JobSystem.h"
+#include "Shader.h"
+
+enum class LightType {
+    POINT,
+    SPOT
+};
+
+struct Light {
+    LightType type = LightType::POINT;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    float range = 1.0f;
+    float inner_angle = 20.0f;
+    float outer_angle = 30.0f;
+};
+
+struct DirectionalLight {
+    glm::vec3 direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    glm::vec3 ambient = glm::vec3(0.4f);
+    glm::vec3 diffuse = glm::vec3(0.6f);
+    glm::vec3 specular = glm::vec3(0.2f);
+};
+
+// Clustered forward lighting. The view frustum is split into a grid of froxels (screen tiles x
+// exponential depth slices); every frame each point/spot light is assigned to the froxels its
+// bounding sphere touches and the per-froxel lists are uploaded as texture buffers, so a
+// fragment only loops over the lights of its own cluster.
+class LightManager {
+public:
+    LightManager() = default;
+    ~LightManager() = default;
+
+    size_t AddLight(const Light& light);
+    inline Light& GetLight(size_t index);
+    inline size_t LightNum() const;
+    void SetLights(const std::vector<Light>& lights);
+    void ClearLights();
+    void SetDirectionalLight(const DirectionalLight& light);
+    inline const DirectionalLight& GetDirectionalLight() const;
+    void SetJobSystem(JobSystem* jobs);
+
+    void Update(const glm::mat4& view, const glm::mat4& projection, float z_near, float z_far,
+        int width, int height);
+    void Upload();
+    void Apply(const Shader& shader) const;
+    inline size_t AssignedIndexNum() const;
+
+    static constexpr int CLUSTER_X = 16;
+    static constexpr int CLUSTER_Y = 9;
+    static constexpr int CLUSTER_Z = 24;
+    static constexpr int CLUSTER_NUM = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+    static constexpr int LIGHT_DATA_UNIT = 9;
+    static constexpr int CLUSTER_GRID_UNIT = 10;
+    static constexpr int LIGHT_INDEX_UNIT = 11;
+
+private:
+    struct ClusterBounds {
+        float min[3];
+        float max[3];
+    };
+
+    struct SliceOutput {
+        std::vector<uint32_t> counts = {};
+        std::vector<uint32_t> indices = {};
+        std::vector<uint32_t> candidates = {};
+        std::vector<float> packed = {};
+    };
+
+    void BuildClusterBounds(const glm::mat4& projection, float z_near, float z_far);
+    void AssignSlice(int slice);
+    int SliceOf(float depth) const;
+
+    std::vector<Light> lights_ = {};
+    DirectionalLight directional_light_ = {};
+    JobSystem* jobs_ = nullptr;
+
+    // view space light spheres
+    std::vector<float> light_x_ = {};
+    std::vector<float> light_y_ = {};
+    std::vector<float> light_z_ = {};
+    std::vector<float> light_radius_ = {};
+    std::vector<int> light_slice_min_ = {};
+    std::vector<int> light_slice_max_ = {};
+
+    std::vector<ClusterBounds> cluster_bounds_ = {};
+    std::vector<SliceOutput> slices_ = {};
+    std::vector<uint32_t> cluster_grid_ = {};
+    std::vector<uint32_t> light_indices_ = {};
+    std::vector<float> light_data_ = {};
+    float z_near_ = 0.0f;
+    float z_far_ = 0.0f;
+    float bounds_proj_x_ = 0.0f;
+    float bounds_proj_y_ = 0.0f;
+    int width_ = 1;
+    int height_ = 1;
+
+    unsigned int light_data_buffer_ = 0;
+    unsigned int light_data_texture_ = 0;
+    unsigned int cluster_grid_buffer_ = 0;
+    unsigned int cluster_grid_texture_ = 0;
+    unsigned int light_index_buffer_ = 0;
+    unsigned int light_index_texture_ = 0;
+};
+
+Light& LightManager::GetLight(size_t index) {
+    return lights_[index];
+}
+
+const DirectionalLight& LightManager::GetDirectionalLight() const {
+    return directional_light_;
+}
+
+size_t LightManager::LightNum() const {
+    return lights_.size();
+}
+
+size_t LightManager::AssignedIndexNum() const {
+    return light_indices_.size();
+}
+
+#endif  // SRC_LIGHTMANAGER_H_
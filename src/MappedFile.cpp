@@ -0,0 +1,88 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    file_ = file;
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) {
+        return true;
+    }
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ != nullptr) {
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    fstat(file, &info);
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ == 0) {
+        close(file);
+        return true;
+    }
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    // the mapping keeps its own reference to the file
+    close(file);
+    if (data != MAP_FAILED) {
+        data_ = static_cast<const char*>(data);
+    }
+#endif
+    if (data_ == nullptr) {
+        std::cout << "ERROR::MAPPED_FILE::MAP_FAILED " << path << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr) {
+        CloseHandle(file_);
+    }
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef SRC_MAPPEDFILE_H_
+#define SRC_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in by the OS on first touch, so
+// opening is cheap and only the parts actually read become resident.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    inline const char* Data() const;
+    inline size_t Size() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+const char* MappedFile::Data() const {
+    return data_;
+}
+
+size_t MappedFile::Size() const {
+    return size_;
+}
+
+#endif  // SRC_MAPPEDFILE_H_
@@ -24,63 +24,76 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>&
     SetupMesh();
 }
 
-void Mesh::Draw(Shader& shader) {
-    unsigned int diffuse_index = 1;
-    unsigned int specular_index = 1;
-    unsigned int normal_index = 1;
-    unsigned int height_index = 1;
-    for (unsigned int i = 0; i < textures_.size(); i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        std::string number;
-        std::string name = textures_[i].type;
-        if (name == "texture_diffuse") {
-            number = std::to_string(diffuse_index++);
-        } else if (name == "texture_specular") {
-            number = std::to_string(specular_index++);
-        } else if (name == "texture_normal") {
-            number = std::to_string(normal_index++);
-        } else if (name == "texture_height") {
-            number = std::to_string(height_index++);
+MeshUniforms::MeshUniforms(const Shader& shader) {
+    static const char* TEXTURE_TYPES[TEXTURE_TYPE_NUM] = {
+        "texture_diffuse", "texture_specular", "texture_normal", "texture_height"
+    };
+    for (int i = 0; i < TEXTURE_TYPE_NUM; i++) {
+        for (int j = 0; j < MAX_TEXTURES_PER_TYPE; j++) {
+            texture_samplers[i][j] =
+                shader.Location(std::string(TEXTURE_TYPES[i]) + std::to_string(j + 1));
+        }
+    }
+    diffuse_layer = shader.Location("diffuse_layer");
+    shininess = shader.Location("material.shininess");
+    opacity = shader.Location("material.opacity");
+    density = shader.Location("material.density");
+    illum = shader.Location("material.illum");
+    ambient = shader.Location("material.ambient");
+    diffuse = shader.Location("material.diffuse");
+    specular = shader.Location("material.specular");
+}
+
+void Mesh::Record(CommandBuffer& commands, const MeshUniforms& uniforms) const {
+    if (textures_.empty()) {
+        // always recorded, or a mesh without a texture would keep the previous mesh's layer;
+        // -1 makes the shader fall back to a flat color
+        int layer = material_ ? material_->diffuse_layer : -1;
+        commands.Push(UniformIntCommand{ uniforms.diffuse_layer, layer });
+    } else {
+        int type_indices[MeshUniforms::TEXTURE_TYPE_NUM] = {};
+        for (unsigned int i = 0; i < textures_.size(); i++) {
+            commands.Push(BindTextureCommand{ i, TextureTarget::TEXTURE_2D, textures_[i].id });
+            const std::string& name = textures_[i].type;
+            int type = 0;
+            if (name == "texture_diffuse") {
+                type = 0;
+            } else if (name == "texture_specular") {
+                type = 1;
+            } else if (name == "texture_normal") {
+                type = 2;
+            } else if (name == "texture_height") {
+                type = 3;
+            } else {
+                continue;
+            }
+            int index = type_indices[type]++;
+            if (index < MeshUniforms::MAX_TEXTURES_PER_TYPE) {
+                commands.Push(UniformIntCommand{ uniforms.texture_samplers[type][index],
+                    static_cast<int>(i) });
+            }
         }
-        glUniform1i(glGetUniformLocation(shader.Id(), (name + number).c_str()), i);
     }
     if (material_) {
-        glUniform1f(glGetUniformLocation(shader.Id(), "material.shininess"),
-            material_->shininess);
-        glUniform1f(glGetUniformLocation(shader.Id(), "material.opacity"),
-            material_->opacity);
-        glUniform1f(glGetUniformLocation(shader.Id(), "material.density"),
-            material_->density);
-        glUniform1f(glGetUniformLocation(shader.Id(), "material.illum"),
-            material_->illum);
-        glUniform3f(glGetUniformLocation(shader.Id(), "material.ambient"),
-            material_->ambient[0], material_->ambient[1], material_->ambient[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "material.diffuse"),
-            material_->diffuse[0], material_->diffuse[1], material_->diffuse[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "material.specular"),
-            material_->specular[0], material_->specular[1], material_->specular[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "material.ambient"),
-            material_->ambient[0], material_->ambient[1], material_->ambient[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "material.diffuse"),
-            material_->diffuse[0], material_->diffuse[1], material_->diffuse[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "material.specular"),
-            material_->specular[0], material_->specular[1], material_->specular[2]);
-
-        // TODO: deal with light
-        glm::vec3 const_one(1.0f);
-        glUniform3f(glGetUniformLocation(shader.Id(), "light.ambient"),
-            const_one[0], const_one[1], const_one[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "light.diffuse"),
-            const_one[0], const_one[1], const_one[2]);
-        glUniform3f(glGetUniformLocation(shader.Id(), "light.specular"),
-            const_one[0], const_one[1], const_one[2]);
+        commands.Push(UniformFloatCommand{ uniforms.shininess, material_->shininess });
+        commands.Push(UniformFloatCommand{ uniforms.opacity, material_->opacity });
+        commands.Push(UniformFloatCommand{ uniforms.density, material_->density });
+        commands.Push(UniformFloatCommand{ uniforms.illum, material_->illum });
+        commands.Push(UniformVec3Command{ uniforms.ambient,
+            { material_->ambient[0], material_->ambient[1], material_->ambient[2] } });
+        commands.Push(UniformVec3Command{ uniforms.diffuse,
+            { material_->diffuse[0], material_->diffuse[1], material_->diffuse[2] } });
+        commands.Push(UniformVec3Command{ uniforms.specular,
+            { material_->specular[0], material_->specular[1], material_->specular[2] } });
     }
 
-    glBindVertexArray(vao_);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices_.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    commands.Push(BindVertexArrayCommand{ vao_ });
+    commands.Push(DrawIndexedCommand{ static_cast<unsigned int>(indices_.size()), 0 });
+}
 
-    glActiveTexture(GL_TEXTURE0);
+void Mesh::RecordDepth(CommandBuffer& commands) const {
+    commands.Push(BindVertexArrayCommand{ depth_vao_ });
+    commands.Push(DrawIndexedCommand{ static_cast<unsigned int>(indices_.size()), 0 });
 }
 
 void Mesh::SetupMesh() {
@@ -124,4 +137,24 @@ void Mesh::SetupMesh() {
     glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
         reinterpret_cast<void*>(offsetof(Vertex, weights)));
     glBindVertexArray(0);
+
+    std::vector<glm::vec3> positions(vertices_.size());
+    bounds_min_ = vertices_.empty() ? glm::vec3(0.0f) : vertices_[0].position;
+    bounds_max_ = bounds_min_;
+    for (size_t i = 0; i < vertices_.size(); i++) {
+        positions[i] = vertices_[i].position;
+        bounds_min_ = glm::min(bounds_min_, positions[i]);
+        bounds_max_ = glm::max(bounds_max_, positions[i]);
+    }
+
+    glGenVertexArrays(1, &depth_vao_);
+    glGenBuffers(1, &position_vbo_);
+    glBindVertexArray(depth_vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, position_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(),
+        GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    glBindVertexArray(0);
 }
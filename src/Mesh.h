@@ -7,6 +7,7 @@
 
 #include <glm/glm.hpp>
 
+#include "CommandBuffer.h"
 #include "Shader.h"
 #include <assimp/scene.h>
 
@@ -24,12 +25,14 @@ struct Vertex {
 
 struct Material {
     float shininess;
-    float opacity;
+    float opacity = 1.0f;
     float density;
     float illum;
     glm::vec3 ambient;
     glm::vec3 diffuse;
     glm::vec3 specular;
+    int diffuse_array = -1;
+    int diffuse_layer = -1;
 };
 
 struct Texture {
@@ -38,6 +41,24 @@ struct Texture {
     std::string path;
 };
 
+// Uniform locations a mesh writes, resolved once per shader so recording never touches GL.
+struct MeshUniforms {
+    explicit MeshUniforms(const Shader& shader);
+
+    static constexpr int TEXTURE_TYPE_NUM = 4;
+    static constexpr int MAX_TEXTURES_PER_TYPE = 4;
+
+    int texture_samplers[TEXTURE_TYPE_NUM][MAX_TEXTURES_PER_TYPE] = {};
+    int diffuse_layer = -1;
+    int shininess = -1;
+    int opacity = -1;
+    int density = -1;
+    int illum = -1;
+    int ambient = -1;
+    int diffuse = -1;
+    int specular = -1;
+};
+
 class Mesh {
 public:
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
@@ -46,7 +67,14 @@ public:
         const std::vector<Texture>& textures, std::shared_ptr<Material>&& material);
     ~Mesh() = default;
 
-    void Draw(Shader& shader);
+    void Record(CommandBuffer& commands, const MeshUniforms& uniforms) const;
+    void RecordDepth(CommandBuffer& commands) const;
+    inline int TextureArray() const;
+    inline float Opacity() const;
+    inline const glm::vec3& BoundsMin() const;
+    inline const glm::vec3& BoundsMax() const;
+    inline const std::vector<Vertex>& Vertices() const;
+    inline const std::vector<unsigned int>& Indices() const;
 
 private:
     void SetupMesh();
@@ -54,10 +82,39 @@ private:
     unsigned int vao_ = 0;
     unsigned int vbo_ = 0;
     unsigned int ebo_ = 0;
+    // position-only stream sharing ebo_, for depth-only passes
+    unsigned int depth_vao_ = 0;
+    unsigned int position_vbo_ = 0;
+    glm::vec3 bounds_min_ = glm::vec3(0.0f);
+    glm::vec3 bounds_max_ = glm::vec3(0.0f);
     std::shared_ptr<Material> material_ = nullptr;
     std::vector<Vertex> vertices_ = {};
     std::vector<unsigned int> indices_ = {};
     std::vector<Texture> textures_ = {};
 };
 
+int Mesh::TextureArray() const {
+    return material_ ? material_->diffuse_array : -1;
+}
+
+float Mesh::Opacity() const {
+    return material_ ? material_->opacity : 1.0f;
+}
+
+const glm::vec3& Mesh::BoundsMin() const {
+    return bounds_min_;
+}
+
+const glm::vec3& Mesh::BoundsMax() const {
+    return bounds_max_;
+}
+
+const std::vector<Vertex>& Mesh::Vertices() const {
+    return vertices_;
+}
+
+const std::vector<unsigned int>& Mesh::Indices() const {
+    return indices_;
+}
+
 #endif  // SRC_MESH_H_
@@ -1,6 +1,9 @@
 #include "Model.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <utility>
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
@@ -8,12 +11,127 @@
 #include <glm/glm.hpp>
 #include <stb_image.h>
 
+#include "Path.h"
+#include "VfsIOSystem.h"
+
+namespace {
+
+UniformMat4Command ModelMatrixCommand(int location, const glm::mat4& transform) {
+    UniformMat4Command command = { location, {} };
+    std::memcpy(command.value, &transform[0][0], sizeof(command.value));
+    return command;
+}
+
+}  // namespace
+
 Model::Model(bool gamma) : gamma_correction_(gamma) {}
 
-void Model::Draw(Shader& shader, bool use_material) {
-    glUniform1i(glGetUniformLocation(shader.Id(), "use_material"), use_material);
-    for (unsigned int i = 0; i < meshes_.size(); i++) {
-        meshes_[i].Draw(shader);
+void Model::PrepareRecord(const Shader& shader) {
+    if (mesh_uniforms_ && mesh_uniforms_program_ == shader.Id()) {
+        return;
+    }
+    mesh_uniforms_.reset(new MeshUniforms(shader));
+    mesh_uniforms_program_ = shader.Id();
+    model_location_ = shader.Location("model");
+    use_material_location_ = shader.Location("use_material");
+    use_texture_array_location_ = shader.Location("use_texture_array");
+    texture_array_location_ = shader.Location("texture_array");
+}
+
+void Model::Record(CommandBuffer& commands, const glm::mat4& transform, bool use_material,
+    const unsigned int* meshes, size_t mesh_num) const {
+    commands.Push(ModelMatrixCommand(model_location_, transform));
+    commands.Push(UniformIntCommand{ use_material_location_, use_material });
+    commands.Push(UniformIntCommand{ use_texture_array_location_, texture_arrays_ != nullptr });
+    if (!texture_arrays_ || !texture_arrays_->Bindless()) {
+        // keep the array sampler off unit 0 even when unused, GL rejects draws where samplers of
+        // different types share a unit
+        commands.Push(UniformIntCommand{ texture_array_location_,
+            TextureArrayPool::TEXTURE_UNIT });
+    }
+    const MeshUniforms& uniforms = *mesh_uniforms_;
+    for (size_t i = 0; i < mesh_num; i++) {
+        const Mesh& mesh = meshes_[meshes[i]];
+        // rebinding the same array per mesh is free, the replayer drops redundant binds
+        int array = mesh.TextureArray();
+        if (array >= 0) {
+            texture_arrays_->Record(commands, array, texture_array_location_);
+        }
+        mesh.Record(commands, uniforms);
+    }
+}
+
+void Model::RecordDepth(CommandBuffer& commands, int model_location, const glm::mat4& transform,
+    const unsigned int* meshes, size_t mesh_num) const {
+    commands.Push(ModelMatrixCommand(model_location, transform));
+    for (size_t i = 0; i < mesh_num; i++) {
+        meshes_[meshes[i]].RecordDepth(commands);
+    }
+}
+
+void Model::FillDrawList(std::vector<unsigned int>& draw_list) const {
+    draw_list = opaque_meshes_;
+}
+
+void Model::FillTransparentDrawList(std::vector<unsigned int>& draw_list) const {
+    draw_list = transparent_meshes_;
+}
+
+size_t Model::CullFrustum(const glm::mat4& model_view_projection,
+    std::vector<unsigned int>& draw_list) const {
+    Frustum frustum(model_view_projection);
+    size_t size = draw_list.size();
+    draw_list.erase(std::remove_if(draw_list.begin(), draw_list.end(), [&](unsigned int mesh) {
+        return !frustum.Intersects(meshes_[mesh].BoundsMin(), meshes_[mesh].BoundsMax());
+    }), draw_list.end());
+    return size - draw_list.size();
+}
+
+void Model::GatherOccluders(const glm::mat4& model_view_projection,
+    const std::vector<unsigned int>& draw_list, const OcclusionBuffer& occlusion,
+    unsigned int owner, std::vector<OccluderCandidate>& candidates) const {
+    for (unsigned int mesh : draw_list) {
+        size_t index_num = meshes_[mesh].Indices().size();
+        if (index_num == 0 || index_num > MAX_OCCLUDER_TRIANGLES * 3) {
+            continue;
+        }
+        float area = occlusion.ScreenArea(model_view_projection, meshes_[mesh].BoundsMin(),
+            meshes_[mesh].BoundsMax());
+        if (area > 0.0f) {
+            candidates.push_back(OccluderCandidate{ area, owner, mesh });
+        }
+    }
+}
+
+void Model::RasterizeOccluder(const glm::mat4& model_view_projection, unsigned int mesh,
+    OcclusionBuffer& occlusion) const {
+    const Mesh& occluder = meshes_[mesh];
+    occlusion.RasterizeTriangles(model_view_projection, &occluder.Vertices()[0].position.x,
+        sizeof(Vertex), occluder.Vertices().size(), occluder.Indices().data(),
+        occluder.Indices().size());
+}
+
+size_t Model::CullOccluded(const glm::mat4& model_view_projection,
+    const OcclusionBuffer& occlusion, std::vector<unsigned int>& draw_list) const {
+    size_t size = draw_list.size();
+    draw_list.erase(std::remove_if(draw_list.begin(), draw_list.end(), [&](unsigned int mesh) {
+        return !occlusion.IsVisible(model_view_projection, meshes_[mesh].BoundsMin(),
+            meshes_[mesh].BoundsMax());
+    }), draw_list.end());
+    return size - draw_list.size();
+}
+
+void Model::SortFrontToBack(const glm::mat4& model_view,
+    std::vector<unsigned int>& draw_list) const {
+    std::vector<std::pair<float, unsigned int>> keys(draw_list.size());
+    for (size_t i = 0; i < draw_list.size(); i++) {
+        const Mesh& mesh = meshes_[draw_list[i]];
+        glm::vec3 center = (mesh.BoundsMin() + mesh.BoundsMax()) * 0.5f;
+        keys[i] = std::make_pair(-(model_view * glm::vec4(center, 1.0f)).z, draw_list[i]);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size(); i++) {
+        draw_list[i] = keys[i].second;
     }
 }
 
@@ -21,26 +139,68 @@ void Model::SetFixedTexturePath(const std::string& path) {
     fixed_tex_path_ = path;
 }
 
-void Model::LoadModel(std::string const& path) {
+void Model::SetJobSystem(JobSystem* jobs) {
+    jobs_ = jobs;
+}
+
+void Model::SetFileSystem(const VirtualFileSystem* vfs) {
+    vfs_ = vfs;
+}
+
+void Model::LoadModel(std::string const& path, TextureArrayPool* texture_arrays) {
+    texture_arrays_ = texture_arrays;
     Assimp::Importer importer;
+    if (vfs_ != nullptr) {
+        // the importer takes ownership of the handler
+        importer.SetIOHandler(new VfsIOSystem(*vfs_));
+    }
     const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate |
         aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
         return;
     }
-    directory_ = path.substr(0, path.find_last_of('\\'));
+    directory_ = ParentPath(path);
 
-    ProcessNode(scene->mRootNode, scene);
+    std::vector<aiMesh*> ai_meshes;
+    ProcessNode(scene->mRootNode, scene, ai_meshes);
+
+    // geometry conversion only reads the aiScene, so it runs on the job system; material,
+    // texture and buffer setup touch GL and stay on the context thread
+    std::vector<MeshGeometry> geometries(ai_meshes.size());
+    auto process_geometry = [&ai_meshes, &geometries](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            ProcessGeometry(ai_meshes[i], geometries[i]);
+        }
+    };
+    if (jobs_) {
+        jobs_->ParallelFor(ai_meshes.size(), 1, process_geometry);
+    } else {
+        process_geometry(0, ai_meshes.size());
+    }
+    for (size_t i = 0; i < ai_meshes.size(); i++) {
+        meshes_.push_back(ProcessMesh(ai_meshes[i], geometries[i], scene));
+    }
+    for (size_t i = 0; i < meshes_.size(); i++) {
+        bounds_min_ = i == 0 ? meshes_[i].BoundsMin() :
+            glm::min(bounds_min_, meshes_[i].BoundsMin());
+        bounds_max_ = i == 0 ? meshes_[i].BoundsMax() :
+            glm::max(bounds_max_, meshes_[i].BoundsMax());
+        // the bucket is fixed here, so the transparent pass never has to sort per frame
+        if (meshes_[i].Opacity() < OPAQUE_OPACITY) {
+            transparent_meshes_.push_back(static_cast<unsigned int>(i));
+        } else {
+            opaque_meshes_.push_back(static_cast<unsigned int>(i));
+        }
+    }
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene) {
+void Model::ProcessNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& meshes) {
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes_.push_back(ProcessMesh(mesh, scene));
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        ProcessNode(node->mChildren[i], scene);
+        ProcessNode(node->mChildren[i], scene, meshes);
     }
 }
 
@@ -48,7 +208,8 @@ void Model::ProcessNode(aiNode* node, const aiScene* scene) {
 std::shared_ptr<Material> Model::LoadMaterial(aiMaterial* mat) {
     std::shared_ptr<Material> material = std::make_shared<Material>();
     material->shininess = 0.0f;
-    material->opacity = 0.0f;
+    // no opacity key means opaque
+    material->opacity = 1.0f;
     material->density = 0.0f;
     material->illum = 0.0f;
     material->ambient = glm::vec3(0.0f);
@@ -89,11 +250,11 @@ std::shared_ptr<Material> Model::LoadMaterial(aiMaterial* mat) {
     return material;
 }
 
-Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<Texture> textures = {};
-    std::shared_ptr<Material> material = nullptr;
+void Model::ProcessGeometry(aiMesh* mesh, MeshGeometry& geometry) {
+    std::vector<Vertex>& vertices = geometry.vertices;
+    std::vector<unsigned int>& indices = geometry.indices;
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(mesh->mNumFaces * 3);
 
     // process vertices
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
@@ -142,6 +303,11 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
             indices.push_back(face.mIndices[j]);
         }
     }
+}
+
+Mesh Model::ProcessMesh(aiMesh* mesh, const MeshGeometry& geometry, const aiScene* scene) {
+    std::vector<Texture> textures = {};
+    std::shared_ptr<Material> material = nullptr;
 
     // process materials
     aiMaterial* mat = scene->mMaterials[mesh->mMaterialIndex];
@@ -149,7 +315,23 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
         material = LoadMaterial(mat);
     }
 
-    if (fixed_tex_path_.empty()) {
+    if (texture_arrays_) {
+        if (!material) {
+            material = std::make_shared<Material>();
+        }
+        TextureSlot slot;
+        if (fixed_tex_path_.empty()) {
+            aiString str;
+            if (mat && mat->GetTextureCount(aiTextureType_DIFFUSE) > 0 &&
+                mat->GetTexture(aiTextureType_DIFFUSE, 0, &str) == AI_SUCCESS) {
+                slot = TextureSlotFromFile(str.C_Str(), directory_);
+            }
+        } else {
+            slot = TextureSlotFromFile(fixed_tex_path_.c_str(), "");
+        }
+        material->diffuse_array = slot.array;
+        material->diffuse_layer = slot.layer;
+    } else if (fixed_tex_path_.empty()) {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
         std::vector<Texture> diffuse_maps = LoadTextures(material, aiTextureType_DIFFUSE,
@@ -176,7 +358,7 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
         textures.push_back(texture);
     }
 
-    return Mesh(vertices, indices, textures, std::move(material));
+    return Mesh(geometry.vertices, geometry.indices, textures, std::move(material));
 }
 
 std::vector<Texture> Model::LoadTextures(aiMaterial* mat, aiTextureType type,
@@ -238,14 +420,26 @@ unsigned int Model::TextureFromData(void* data, int width, int height, int compo
     return texture_id;
 }
 
+unsigned char* Model::LoadImage(const std::string& path, int& width, int& height,
+    int& component_num) const {
+    static const VirtualFileSystem loose_files;
+    FileView file = (vfs_ != nullptr ? *vfs_ : loose_files).Open(path);
+    if (!file.Valid()) {
+        return nullptr;
+    }
+    // decoded straight from the mapped bytes
+    return stbi_load_from_memory(reinterpret_cast<const unsigned char*>(file.Data()),
+        static_cast<int>(file.Size()), &width, &height, &component_num, 0);
+}
+
 unsigned int Model::TextureFromFile(const char* path, const std::string& directory, bool gamma) {
     std::string filename = std::string(path);
-    filename = !directory.empty() ? directory + '\\' + filename : filename;
+    filename = JoinPath(directory, filename);
 
     int width = 0;
     int height = 0;
     int component_num = 0;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &component_num, 0);
+    unsigned char* data = LoadImage(filename, width, height, component_num);
     unsigned int texture_id = 0;
     if (data) {
         texture_id = TextureFromData(data, width, height, component_num);
@@ -257,3 +451,25 @@ unsigned int Model::TextureFromFile(const char* path, const std::string& directo
 
     return texture_id;
 }
+
+TextureSlot Model::TextureSlotFromFile(const char* path, const std::string& directory) {
+    std::string filename = std::string(path);
+    filename = JoinPath(directory, filename);
+
+    TextureSlot slot = texture_arrays_->Find(filename);
+    if (slot.layer >= 0) {
+        return slot;
+    }
+    int width = 0;
+    int height = 0;
+    int component_num = 0;
+    unsigned char* data = LoadImage(filename, width, height, component_num);
+    if (data) {
+        slot = texture_arrays_->AddImage(filename, data, width, height, component_num);
+    } else {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    }
+    stbi_image_free(data);
+
+    return slot;
+}
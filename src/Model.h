@@ -1,26 +1,73 @@
 #ifndef SRC_MODEL_H_
 #define SRC_MODEL_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <assimp/scene.h>
 
+#include "CommandBuffer.h"
+#include "Culling.h"
+#include "JobSystem.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "TextureArray.h"
+#include "VirtualFileSystem.h"
+
+struct MeshGeometry {
+    std::vector<Vertex> vertices = {};
+    std::vector<unsigned int> indices = {};
+};
 
 class Model {
 public:
     Model(bool gamma = false);
     ~Model() = default;
 
-    void LoadModel(std::string const& path);
-    void Draw(Shader& shader, bool use_material);
+    // Diffuse textures go into the given pool, which the renderer shares between all of its
+    // models so that equal images are stored once and draws of different models share arrays.
+    // The caller uploads the pool once every model using it is loaded. Without a pool each
+    // mesh binds its own 2D textures.
+    void LoadModel(std::string const& path, TextureArrayPool* texture_arrays = nullptr);
+    // Recording is split from submission. PrepareRecord resolves the uniform locations of the
+    // shader on the context thread; after that Record and RecordDepth only read the model, so
+    // any number of instances record on worker threads at once. Both write the model matrix
+    // first, a buffer holds everything its meshes need.
+    void PrepareRecord(const Shader& shader);
+    void Record(CommandBuffer& commands, const glm::mat4& transform, bool use_material,
+        const unsigned int* meshes, size_t mesh_num) const;
+    void RecordDepth(CommandBuffer& commands, int model_location, const glm::mat4& transform,
+        const unsigned int* meshes, size_t mesh_num) const;
+
+    // A draw list holds mesh indices in submission order; it starts with every mesh of a bucket
+    // and is narrowed by the culling passes. Meshes are split into the opaque and the
+    // transparent bucket by material opacity at import.
+    void FillDrawList(std::vector<unsigned int>& draw_list) const;
+    void FillTransparentDrawList(std::vector<unsigned int>& draw_list) const;
+    inline size_t TransparentMeshNum() const;
+    size_t CullFrustum(const glm::mat4& model_view_projection,
+        std::vector<unsigned int>& draw_list) const;
+    // appends the meshes of the draw list that are cheap enough to rasterize and cover part of
+    // the screen, tagged with owner
+    void GatherOccluders(const glm::mat4& model_view_projection,
+        const std::vector<unsigned int>& draw_list, const OcclusionBuffer& occlusion,
+        unsigned int owner, std::vector<OccluderCandidate>& candidates) const;
+    void RasterizeOccluder(const glm::mat4& model_view_projection, unsigned int mesh,
+        OcclusionBuffer& occlusion) const;
+    size_t CullOccluded(const glm::mat4& model_view_projection, const OcclusionBuffer& occlusion,
+        std::vector<unsigned int>& draw_list) const;
+    void SortFrontToBack(const glm::mat4& model_view, std::vector<unsigned int>& draw_list) const;
     void SetFixedTexturePath(const std::string& path);
+    void SetJobSystem(JobSystem* jobs);
+    void SetFileSystem(const VirtualFileSystem* vfs);
+    inline const glm::vec3& BoundsMin() const;
+    inline const glm::vec3& BoundsMax() const;
 
 private:
-    void ProcessNode(aiNode* node, const aiScene* scene);
-    Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
+    void ProcessNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& meshes);
+    static void ProcessGeometry(aiMesh* mesh, MeshGeometry& geometry);
+    Mesh ProcessMesh(aiMesh* mesh, const MeshGeometry& geometry, const aiScene* scene);
     std::shared_ptr<Material> LoadMaterial(aiMaterial* mat);
     std::vector<Texture> LoadTextures(aiMaterial* mat, aiTextureType type,
         const std::string& type_name, const aiScene* scene);
@@ -28,12 +75,43 @@ private:
         int component_num);
     unsigned int TextureFromFile(const char* path, const std::string& directory,
         bool gamma);
+    unsigned char* LoadImage(const std::string& path, int& width, int& height,
+        int& component_num) const;
+    TextureSlot TextureSlotFromFile(const char* path, const std::string& directory);
 
     bool gamma_correction_ = false;
     std::vector<Texture> textures_loaded_ = {};
     std::vector<Mesh> meshes_ = {};
+    std::vector<unsigned int> opaque_meshes_ = {};
+    std::vector<unsigned int> transparent_meshes_ = {};
+    glm::vec3 bounds_min_ = glm::vec3(0.0f);
+    glm::vec3 bounds_max_ = glm::vec3(0.0f);
     std::string directory_;
     std::string fixed_tex_path_;
+    TextureArrayPool* texture_arrays_ = nullptr;
+    JobSystem* jobs_ = nullptr;
+    const VirtualFileSystem* vfs_ = nullptr;
+    std::unique_ptr<MeshUniforms> mesh_uniforms_ = nullptr;
+    unsigned int mesh_uniforms_program_ = 0;
+    int model_location_ = -1;
+    int use_material_location_ = -1;
+    int use_texture_array_location_ = -1;
+    int texture_array_location_ = -1;
+
+    static constexpr size_t MAX_OCCLUDER_TRIANGLES = 4096;
+    static constexpr float OPAQUE_OPACITY = 0.99f;
 };
 
+const glm::vec3& Model::BoundsMin() const {
+    return bounds_min_;
+}
+
+const glm::vec3& Model::BoundsMax() const {
+    return bounds_max_;
+}
+
+size_t Model::TransparentMeshNum() const {
+    return transparent_meshes_.size();
+}
+
 #endif  // SRC_MODEL_H_
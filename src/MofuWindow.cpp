@@ -1,17 +1,23 @@
 #include "MofuWindow.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <thread>
 
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include "Mesh.h"
-#include "Model.h"
-#include "Shader.h"
+#include "Path.h"
+#include "SceneSystems.h"
 
 bool MofuWindow::mouse_pressed_ = false;
 float MofuWindow::last_x_ = SCR_WIDTH / 2.0f;
@@ -23,7 +29,7 @@ void MofuWindow::ShowWindow() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, WINDOW_NAME, nullptr, nullptr);
     if (window == nullptr) {
@@ -50,22 +56,207 @@ void MofuWindow::ShowWindow() {
         camera_.ProcessMouseScroll(static_cast<float>(yoffset));
     });
 
+    if (threaded_render_) {
+        // the render thread owns the context from here on, this thread only updates
+        glfwMakeContextCurrent(nullptr);
+        running_ = true;
+        std::thread render_thread([this, window]() {
+            RenderLoop(window);
+        });
+        // without a frame cap the update loop still must not spin, so pace it at the tick rate
+        if (!pacer_.Enabled()) {
+            pacer_.SetTargetFps(1.0 / timestep_.TickSeconds());
+        }
+        // the scene is built by the render thread together with its assets
+        while (running_ && !scene_ready_) {
+            glfwPollEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        timestep_.Reset();
+        while (running_ && !glfwWindowShouldClose(window)) {
+            glfwPollEvents();
+            UpdateFrame(window, snapshots_.WriteBuffer());
+            snapshots_.Publish();
+            pacer_.Wait();
+        }
+        running_ = false;
+        render_thread.join();
+        // the render thread let go of the context, GL objects below are deleted from here
+        glfwMakeContextCurrent(window);
+    } else if (InitRenderer()) {
+        FrameSnapshot snapshot;
+        timestep_.Reset();
+        while (!glfwWindowShouldClose(window)) {
+            glfwPollEvents();
+            UpdateFrame(window, snapshot);
+            RenderFrame(snapshot);
+            glfwSwapBuffers(window);
+            ReportLatency(snapshot.input_time);
+            pacer_.Wait();
+        }
+    }
+
+    streamer_.Stop();
+    std::cout << "Streaming: " << streamer_.ResidentChunkNum() << " chunks resident, " <<
+        streamer_.ResidentDataBytes() / 1024 << " KiB of chunk data" << std::endl;
+    ReportOverdraw();
+    ReportShadows();
+    ReportFrameData();
+    ReportResolution();
+    if (latency_frame_num_ > 0) {
+        std::cout << "Input to present latency: avg " << latency_sum_ms_ / latency_frame_num_ <<
+            " ms, max " << latency_max_ms_ << " ms over " << latency_frame_num_ << " frames" <<
+            std::endl;
+    }
+    shaded_samples_.reset();
+    shadow_map_.reset();
+    frame_data_.reset();
+    scene_target_.reset();
+    dynamic_resolution_.reset();
+    transparency_.reset();
+    oit_composite_shader_.reset();
+    models_.clear();
+    texture_arrays_.reset();
+    depth_shader_.reset();
+    shader_.reset();
+    glfwTerminate();
+    return;
+}
+
+void MofuWindow::SetThreadedRender(bool threaded_render) {
+    threaded_render_ = threaded_render;
+}
+
+void MofuWindow::SetVsync(bool vsync) {
+    vsync_ = vsync;
+}
+
+void MofuWindow::SetMaxFps(double max_fps) {
+    pacer_.SetTargetFps(max_fps);
+}
+
+void MofuWindow::SetDepthPrepass(bool depth_prepass) {
+    depth_prepass_ = depth_prepass;
+}
+
+void MofuWindow::SetSortFrontToBack(bool sort_front_to_back) {
+    sort_front_to_back_ = sort_front_to_back;
+}
+
+void MofuWindow::SetOcclusionCulling(bool occlusion_culling) {
+    occlusion_culling_ = occlusion_culling;
+}
+
+void MofuWindow::SetUseTextureArray(bool use_texture_array) {
+    use_texture_array_ = use_texture_array;
+}
+
+void MofuWindow::SetShadows(bool shadows) {
+    shadows_ = shadows;
+}
+
+void MofuWindow::SetShadowBudget(int cascades_per_frame) {
+    shadow_budget_ = cascades_per_frame;
+}
+
+void MofuWindow::SetDemoInstances(int instance_num) {
+    demo_instance_num_ = instance_num;
+}
+
+void MofuWindow::SetResourceRoot(const std::string& resource_root) {
+    resource_root_ = resource_root;
+}
+
+void MofuWindow::SetScenePath(const std::string& scene_path) {
+    scene_path_ = scene_path;
+}
+
+void MofuWindow::SetStreamingDataBudget(size_t bytes) {
+    streamer_.SetDataBudget(bytes);
+}
+
+void MofuWindow::AddPack(const std::string& pack_path) {
+    pack_paths_.push_back(pack_path);
+}
+
+void MofuWindow::SetTargetFrameTime(double target_ms) {
+    target_frame_ms_ = target_ms;
+}
+
+void MofuWindow::SetMinResolutionScale(float min_scale) {
+    min_resolution_scale_ = min_scale;
+}
+
+bool MofuWindow::InitRenderer() {
     if (glewInit() != GLEW_OK) {
-        return;
+        return false;
     }
 
+    glfwSwapInterval(vsync_ ? 1 : 0);
     stbi_set_flip_vertically_on_load(true);
 
     glEnable(GL_DEPTH_TEST);
 
-    Shader our_shader("..\\..\\..\\..\\shader\\default_shader.vs",
-        "..\\..\\..\\..\\shader\\default_shader.fs");
+    // packs mounted later shadow earlier ones and loose files
+    std::string default_pack = JoinPath(resource_root_, "assets.pack");
+    if (vfs_.Exists(default_pack)) {
+        vfs_.MountPack(default_pack, resource_root_);
+    }
+    for (const std::string& pack_path : pack_paths_) {
+        vfs_.MountPack(pack_path, resource_root_);
+    }
 
-    Model our_model;
-    our_model.SetFixedTexturePath("..\\..\\..\\..\\resources\\texture\\car_texture1.png");
-    our_model.LoadModel("..\\..\\..\\..\\resources\\object\\car.blend");
-    // our_model.LoadModel("..\\..\\..\\..\\resources\\object\\temp.obj");
-    bool use_material = false;
+    shader_.reset(new Shader(JoinPath(resource_root_, "shader/default_shader.vs").c_str(),
+        JoinPath(resource_root_, "shader/default_shader.fs").c_str(), nullptr, &vfs_));
+    depth_shader_.reset(new Shader(JoinPath(resource_root_, "shader/depth_only.vs").c_str(),
+        JoinPath(resource_root_, "shader/depth_only.fs").c_str(), nullptr, &vfs_));
+    oit_composite_shader_.reset(new Shader(
+        JoinPath(resource_root_, "shader/oit_composite.vs").c_str(),
+        JoinPath(resource_root_, "shader/oit_composite.fs").c_str(), nullptr, &vfs_));
+    shader_->BindUniformBlock("CameraBlock", CAMERA_BINDING);
+    depth_shader_->BindUniformBlock("CameraBlock", CAMERA_BINDING);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment_);
+    frame_data_.reset(new GpuRingBuffer());
+    if (!frame_data_->Init(GL_UNIFORM_BUFFER, FRAME_DATA_REGION_SIZE)) {
+        return false;
+    }
+    shaded_samples_.reset(new SampleCounter());
+    scene_target_.reset(new RenderTarget());
+    dynamic_resolution_.reset(new DynamicResolution());
+    transparency_.reset(new TransparencyPass());
+    dynamic_resolution_->SetScaleRange(min_resolution_scale_, 1.0f);
+    dynamic_resolution_->SetTargetMilliseconds(target_frame_ms_);
+    shadow_map_.reset(new CascadedShadowMap());
+    if (!shadow_map_->Init()) {
+        return false;
+    }
+    shadow_map_->SetBudget(shadow_budget_);
+
+    if (!LoadSceneDescription(vfs_, JoinPath(resource_root_, scene_path_), scene_)) {
+        // without a scene there is still the car to look at
+        scene_ = SceneDescription();
+        SceneModel car;
+        car.path = JoinPath(resource_root_, "resources/object/car.blend");
+        car.texture_path = JoinPath(resource_root_, "resources/texture/car_texture1.png");
+        scene_.models.push_back(car);
+    }
+    if (use_texture_array_) {
+        texture_arrays_.reset(new TextureArrayPool());
+    }
+    for (const SceneModel& scene_model : scene_.models) {
+        std::unique_ptr<Model> model(new Model());
+        model->SetJobSystem(&job_system_);
+        model->SetFileSystem(&vfs_);
+        model->SetFixedTexturePath(scene_model.texture_path);
+        model->LoadModel(scene_model.path, texture_arrays_.get());
+        models_.push_back(std::move(model));
+    }
+    if (texture_arrays_) {
+        texture_arrays_->Upload();
+    }
+
+    light_manager_.SetJobSystem(&job_system_);
+    InitScene();
 
     // mesh test
     /*
@@ -87,68 +278,543 @@ void MofuWindow::ShowWindow() {
     );
     */
 
-    while (!glfwWindowShouldClose(window)) {
-        float current_time = static_cast<float>(glfwGetTime());
-        delta_time_ = (current_time - last_time_) * 10.0f;
-        last_time_ = current_time;
+    return true;
+}
+
+void MofuWindow::UpdateFrame(GLFWwindow* window, FrameSnapshot& snapshot) {
+    snapshot.input_time = std::chrono::steady_clock::now();
+    if (mouse_pressed_) {
+        double xpos_in = 0.0;
+        double ypos_in = 0.0;
+        glfwGetCursorPos(window, &xpos_in, &ypos_in);
+        float xpos = static_cast<float>(xpos_in);
+        float ypos = static_cast<float>(ypos_in);
+        pending_xoffset_ += xpos - last_x_;
+        pending_yoffset_ += last_y_ - ypos;
+        last_x_ = xpos;
+        last_y_ = ypos;
+    }
+
+    int ticks = timestep_.Advance();
+    for (int i = 0; i < ticks; i++) {
+        previous_camera_ = camera_;
+        previous_focus_yaw_ = focus_yaw_;
+        previous_focus_pitch_ = focus_pitch_;
         ProcessInput(window);
+        if (pending_xoffset_ != 0.0f || pending_yoffset_ != 0.0f) {
+            RotateFocus(pending_xoffset_, pending_yoffset_);
+            pending_xoffset_ = 0.0f;
+            pending_yoffset_ = 0.0f;
+            world_.Transforms().Get(focus_entity_).rotation =
+                FocusRotation(focus_yaw_, focus_pitch_);
+        }
+    }
+    float alpha = timestep_.Alpha();
+    Camera camera = Camera::Interpolate(previous_camera_, camera_, alpha);
 
-        if (mouse_pressed_) {
-            double xpos_in = 0.0;
-            double ypos_in = 0.0;
-            glfwGetCursorPos(window, &xpos_in, &ypos_in);
-            float xpos = static_cast<float>(xpos_in);
-            float ypos = static_cast<float>(ypos_in);
-            float xoffset = xpos - last_x_;
-            float yoffset = last_y_ - ypos;
-            last_x_ = xpos;
-            last_y_ = ypos;
-            camera_.ProcessMouseMovement(xoffset, yoffset);
+    snapshot.frame_index = frame_index_++;
+    glfwGetFramebufferSize(window, &snapshot.screen_width, &snapshot.screen_height);
+    float aspect = snapshot.screen_height > 0 ?
+        static_cast<float>(snapshot.screen_width) / snapshot.screen_height : 1.0f;
+    snapshot.projection = glm::perspective(camera.Zoom(), aspect, Z_NEAR, Z_FAR);
+    snapshot.view = camera.GetViewMatrix();
+    snapshot.view_pos = camera.Position();
+
+    streamer_.SetViewer(camera.Position());
+    ApplyStreamedChunks();
+    UpdateTransforms(world_, &job_system_);
+    UpdateBounds(world_, &job_system_);
+    PublishStaticChanges(snapshot);
+    CollectRenderables(world_, snapshot.projection * snapshot.view, &job_system_, snapshot);
+    // the world holds the ticked rotation, only the drawn instance is blended between ticks
+    if (world_.MeshRenderers().Has(focus_entity_)) {
+        Transform blended = world_.Transforms().Get(focus_entity_);
+        blended.rotation = FocusRotation(glm::mix(previous_focus_yaw_, focus_yaw_, alpha),
+            glm::mix(previous_focus_pitch_, focus_pitch_, alpha));
+        snapshot.instance_transforms[world_.MeshRenderers().IndexOf(focus_entity_)] =
+            TransformMatrix(blended);
+    }
+    CollectLights(world_, snapshot.lights);
+}
+
+void MofuWindow::RenderFrame(const FrameSnapshot& snapshot) {
+    // nothing to draw into while minimized
+    if (snapshot.screen_width <= 0 || snapshot.screen_height <= 0 ||
+        !scene_target_->Resize(snapshot.screen_width, snapshot.screen_height)) {
+        return;
+    }
+    int width = dynamic_resolution_->ScaledSize(snapshot.screen_width);
+    int height = dynamic_resolution_->ScaledSize(snapshot.screen_height);
+    frame_data_->BeginFrame();
+
+    light_manager_.SetLights(snapshot.lights);
+    light_manager_.Update(snapshot.view, snapshot.projection, Z_NEAR, Z_FAR, width, height);
+    light_manager_.Upload();
+
+    BuildDrawLists(snapshot);
+    RenderShadows(snapshot);
+    // the shadow maps cost the same at any render scale, so they stay out of the measurement
+    dynamic_resolution_->Begin();
+
+    scene_target_->Bind(width, height);
+    glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (depth_prepass_) {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        depth_shader_->Use();
+        BindCamera(snapshot.view, snapshot.projection);
+        pass_recorder_.Clear();
+        for (size_t i = 0; i < snapshot.visible_instances.size(); i++) {
+            unsigned int instance = snapshot.visible_instances[i];
+            pass_recorder_.Add(*models_[snapshot.instance_models[instance]],
+                snapshot.instance_transforms[instance], draw_lists_[i]);
         }
+        pass_recorder_.RecordDepth(&job_system_, *depth_shader_);
+        prepass_replayer_.Reset();
+        pass_recorder_.Replay(prepass_replayer_);
+        prepass_replayer_.Finish();
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        // depth is final now, only the visible surface passes and nothing is written again
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
 
-        glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    shader_->Use();
+    if (!depth_prepass_) {
+        BindCamera(snapshot.view, snapshot.projection);
+    }
+    shader_->SetVec3("view_pos", snapshot.view_pos);
+    shader_->SetBool("use_clustered_lights", use_clustered_lights_);
+    light_manager_.Apply(*shader_);
+    shader_->SetBool("use_shadows", shadows_);
+    shadow_map_->Apply(*shader_);
 
-        our_shader.Use();
+    // every visible instance records on the job system first, then the whole pass replays
+    pass_recorder_.Clear();
+    for (size_t i = 0; i < snapshot.visible_instances.size(); i++) {
+        unsigned int instance = snapshot.visible_instances[i];
+        pass_recorder_.Add(*models_[snapshot.instance_models[instance]],
+            snapshot.instance_transforms[instance], draw_lists_[i]);
+    }
+    pass_recorder_.Record(&job_system_, *shader_, use_material_);
+    shaded_samples_->Begin();
+    // everything above touched GL directly, from here on state goes through the replayer
+    scene_replayer_.Reset();
+    pass_recorder_.Replay(scene_replayer_);
+    scene_replayer_.Finish();
+    shaded_samples_->End();
 
-        glm::mat4 projection = glm::perspective(camera_.Zoom(),
-            static_cast<float>(SCR_WIDTH) / SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera_.GetViewMatrix();
-        // glm::mat4 view = glm::mat4(1.0f);
-        our_shader.SetMat4("projection", projection);
-        our_shader.SetMat4("view", view);
+    if (depth_prepass_) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+    RenderTransparent(snapshot, width, height);
+    frame_data_->EndFrame();
+    dynamic_resolution_->End();
+    // our_mesh.Draw(*shader_);
 
-        // glm::mat4 model = glm::mat4(1.0f);
-        // model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-        // model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        glm::mat4 model = camera_.GetModelMatrix();
-        our_shader.SetMat4("model", model);
-        our_model.Draw(our_shader, use_material);
-        // our_mesh.Draw(our_shader);
+    scene_target_->BlitToScreen(width, height, snapshot.screen_width, snapshot.screen_height);
+    rendered_pixel_sum_ += static_cast<uint64_t>(width) * height;
+    rendered_frame_num_++;
+}
 
+void MofuWindow::RenderTransparent(const FrameSnapshot& snapshot, int width, int height) {
+    if (transparent_draw_num_ == 0 || !transparency_->Resize(*scene_target_)) {
+        return;
+    }
+    // any draw order gives the same result, so the lists are used exactly as culled
+    transparency_->Begin(width, height);
+    shader_->Use();
+    shader_->SetBool("oit_pass", true);
+    pass_recorder_.Clear();
+    for (size_t i = 0; i < snapshot.visible_instances.size(); i++) {
+        unsigned int instance = snapshot.visible_instances[i];
+        pass_recorder_.Add(*models_[snapshot.instance_models[instance]],
+            snapshot.instance_transforms[instance], transparent_draw_lists_[i]);
+    }
+    pass_recorder_.Record(&job_system_, *shader_, use_material_);
+    transparent_replayer_.Reset();
+    pass_recorder_.Replay(transparent_replayer_);
+    transparent_replayer_.Finish();
+    shader_->SetBool("oit_pass", false);
+    transparency_->End();
+
+    scene_target_->Bind(width, height);
+    transparency_->Composite(*oit_composite_shader_);
+}
+
+void MofuWindow::BuildDrawLists(const FrameSnapshot& snapshot) {
+    glm::mat4 view_projection = snapshot.projection * snapshot.view;
+    size_t instance_num = snapshot.visible_instances.size();
+    transparent_draw_num_ = 0;
+    draw_lists_.resize(instance_num);
+    transparent_draw_lists_.resize(instance_num);
+    for (size_t i = 0; i < instance_num; i++) {
+        unsigned int instance = snapshot.visible_instances[i];
+        const Model& model = *models_[snapshot.instance_models[instance]];
+        glm::mat4 mvp = view_projection * snapshot.instance_transforms[instance];
+        model.FillDrawList(draw_lists_[i]);
+        frustum_culled_num_ += model.CullFrustum(mvp, draw_lists_[i]);
+        model.FillTransparentDrawList(transparent_draw_lists_[i]);
+        frustum_culled_num_ += model.CullFrustum(mvp, transparent_draw_lists_[i]);
+    }
+
+    // the largest meshes on screen over all instances make the occluders, so the raster cost
+    // stays bounded however many instances are visible; all of them go in before any test
+    if (occlusion_culling_) {
+        occlusion_buffer_.Clear();
+        occluder_candidates_.clear();
+        for (size_t i = 0; i < instance_num; i++) {
+            unsigned int instance = snapshot.visible_instances[i];
+            glm::mat4 mvp = view_projection * snapshot.instance_transforms[instance];
+            models_[snapshot.instance_models[instance]]->GatherOccluders(mvp, draw_lists_[i],
+                occlusion_buffer_, instance, occluder_candidates_);
+        }
+        size_t occluder_num = std::min(occluder_candidates_.size(),
+            static_cast<size_t>(MAX_OCCLUDERS));
+        std::partial_sort(occluder_candidates_.begin(),
+            occluder_candidates_.begin() + occluder_num, occluder_candidates_.end(),
+            [](const OccluderCandidate& a, const OccluderCandidate& b) {
+            return a.screen_area > b.screen_area;
+        });
+        for (size_t i = 0; i < occluder_num; i++) {
+            unsigned int instance = occluder_candidates_[i].owner;
+            models_[snapshot.instance_models[instance]]->RasterizeOccluder(
+                view_projection * snapshot.instance_transforms[instance],
+                occluder_candidates_[i].mesh, occlusion_buffer_);
+        }
+        for (size_t i = 0; i < instance_num; i++) {
+            unsigned int instance = snapshot.visible_instances[i];
+            glm::mat4 mvp = view_projection * snapshot.instance_transforms[instance];
+            const Model& model = *models_[snapshot.instance_models[instance]];
+            occluded_num_ += model.CullOccluded(mvp, occlusion_buffer_, draw_lists_[i]);
+            // only opaque meshes occlude, transparent ones can still be hidden behind them
+            occluded_num_ += model.CullOccluded(mvp, occlusion_buffer_,
+                transparent_draw_lists_[i]);
+        }
+    }
+
+    for (size_t i = 0; i < instance_num; i++) {
+        unsigned int instance = snapshot.visible_instances[i];
+        if (sort_front_to_back_) {
+            models_[snapshot.instance_models[instance]]->SortFrontToBack(
+                snapshot.view * snapshot.instance_transforms[instance], draw_lists_[i]);
+        }
+        drawn_mesh_num_ += draw_lists_[i].size();
+        transparent_draw_num_ += transparent_draw_lists_[i].size();
+    }
+    transparent_mesh_sum_ += transparent_draw_num_;
+    cull_frame_num_++;
+}
+
+void MofuWindow::RenderShadows(const FrameSnapshot& snapshot) {
+    if (!shadows_) {
+        return;
+    }
+    // cached cascades only hold static casters, so only static geometry streaming in or out
+    // invalidates them, and only where it lands
+    if (snapshot.static_revision != shadow_static_revision_) {
+        uint64_t change_num = snapshot.static_revision - shadow_static_revision_;
+        if (change_num > static_cast<uint64_t>(FrameSnapshot::STATIC_CHANGE_NUM)) {
+            shadow_map_->MarkStaticDirty();
+        } else {
+            for (uint64_t r = shadow_static_revision_ + 1; r <= snapshot.static_revision; r++) {
+                const StaticChange& change =
+                    snapshot.static_changes[r % FrameSnapshot::STATIC_CHANGE_NUM];
+                shadow_map_->MarkStaticDirty(change.bounds_min, change.bounds_max);
+            }
+        }
+        shadow_static_revision_ = snapshot.static_revision;
+    }
+    shadow_map_->Update(snapshot.view, snapshot.projection, Z_NEAR, Z_FAR,
+        light_manager_.GetDirectionalLight().direction);
+
+    // casters go through the same culling and command recording as the camera passes; off
+    // screen instances still cast, so all of them are considered. Dynamic casters only go into
+    // the per-frame cascades, a cached cascade would keep their old position. All cascades
+    // record in one go, then replay one after another.
+    size_t instance_num = snapshot.instance_transforms.size();
+    shadow_draw_lists_.resize(CascadedShadowMap::CASCADE_NUM * instance_num);
+    size_t cascade_chunks[CascadedShadowMap::CASCADE_NUM + 1] = {};
+    size_t caster_nums[CascadedShadowMap::CASCADE_NUM] = {};
+    pass_recorder_.Clear();
+    for (int c = 0; c < CascadedShadowMap::CASCADE_NUM; c++) {
+        cascade_chunks[c] = pass_recorder_.ChunkNum();
+        if (!shadow_map_->NeedsRender(c)) {
+            continue;
+        }
+        const glm::mat4& light_view = shadow_map_->LightView(c);
+        glm::mat4 light_view_projection = shadow_map_->LightProjection(c) * light_view;
+        bool cached = shadow_map_->Cached(c);
+        for (size_t i = 0; i < instance_num; i++) {
+            const glm::mat4& transform = snapshot.instance_transforms[i];
+            Model& model = *models_[snapshot.instance_models[i]];
+            glm::mat4 mvp = light_view_projection * transform;
+            if (!snapshot.instance_casts_shadows[i] || (cached && !snapshot.instance_static[i]) ||
+                !Frustum(mvp).Intersects(model.BoundsMin(), model.BoundsMax())) {
+                continue;
+            }
+            std::vector<unsigned int>& draw_list = shadow_draw_lists_[c * instance_num + i];
+            model.FillDrawList(draw_list);
+            model.CullFrustum(mvp, draw_list);
+            model.SortFrontToBack(light_view * transform, draw_list);
+            pass_recorder_.Add(model, transform, draw_list);
+            caster_nums[c] += draw_list.size();
+        }
+    }
+    cascade_chunks[CascadedShadowMap::CASCADE_NUM] = pass_recorder_.ChunkNum();
+    pass_recorder_.RecordDepth(&job_system_, *depth_shader_);
+
+    depth_shader_->Use();
+    // cascades only switch the framebuffer layer, which the replayer does not track
+    shadow_replayer_.Reset();
+    for (int c = 0; c < CascadedShadowMap::CASCADE_NUM; c++) {
+        if (!shadow_map_->NeedsRender(c)) {
+            continue;
+        }
+        shadow_map_->BeginCascade(c);
+        BindCamera(shadow_map_->LightView(c), shadow_map_->LightProjection(c));
+        pass_recorder_.Replay(shadow_replayer_, cascade_chunks[c], cascade_chunks[c + 1]);
+        shadow_map_->EndCascade(c, caster_nums[c]);
+        shadow_caster_sums_[c] += caster_nums[c];
+    }
+    shadow_replayer_.Finish();
+    shadow_map_->End(snapshot.screen_width, snapshot.screen_height);
+    shadow_render_sum_ += shadow_map_->RenderedNum();
+    shadow_frame_num_++;
+}
+
+void MofuWindow::RenderLoop(GLFWwindow* window) {
+    glfwMakeContextCurrent(window);
+    if (!InitRenderer()) {
+        running_ = false;
+        glfwMakeContextCurrent(nullptr);
+        return;
+    }
+    while (running_) {
+        if (!snapshots_.Consume()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+        const FrameSnapshot& snapshot = snapshots_.ReadBuffer();
+        RenderFrame(snapshot);
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        ReportLatency(snapshot.input_time);
     }
+    glfwMakeContextCurrent(nullptr);
+}
 
-    glfwTerminate();
-    return;
+void MofuWindow::InitScene() {
+    const Model& car = *models_[0];
+    Bounds car_bounds;
+    car_bounds.local_min = car.BoundsMin();
+    car_bounds.local_max = car.BoundsMax();
+
+    focus_entity_ = world_.CreateEntity();
+    world_.Transforms().Add(focus_entity_, Transform{});
+    // the focus car turns with the mouse
+    world_.MeshRenderers().Add(focus_entity_, MeshRenderer{ 0, true, false });
+    world_.BoundsPool().Add(focus_entity_, car_bounds);
+
+    // extra copies of the car on a grid behind the focus one, for stress testing
+    glm::vec3 size = car.BoundsMax() - car.BoundsMin();
+    float spacing = std::max(std::max(size.x, size.z), 1.0f) * 1.5f;
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(demo_instance_num_))));
+    for (int i = 0; i < demo_instance_num_; i++) {
+        Transform transform;
+        transform.position = glm::vec3((i % side - side / 2) * spacing, 0.0f,
+            -(i / side + 1) * spacing);
+        Entity entity = world_.CreateEntity();
+        world_.Transforms().Add(entity, transform);
+        world_.MeshRenderers().Add(entity, MeshRenderer{ 0 });
+        world_.BoundsPool().Add(entity, car_bounds);
+    }
+
+    streamer_.SetViewer(camera_.Position());
+    streamer_.Start(scene_, vfs_);
+    scene_ready_ = true;
+}
+
+void MofuWindow::ApplyStreamedChunks() {
+    streamer_.Poll(stream_events_);
+    for (StreamedChunk& event : stream_events_) {
+        std::vector<Entity>& entities = chunk_entities_[event.chunk];
+        if (!event.loaded) {
+            for (Entity entity : entities) {
+                AddStaticChange(entity);
+                world_.DestroyEntity(entity);
+            }
+            chunk_entities_.erase(event.chunk);
+            continue;
+        }
+        for (const SceneInstance& instance : event.data.instances) {
+            if (instance.model >= models_.size()) {
+                continue;
+            }
+            const Model& model = *models_[instance.model];
+            Transform transform;
+            transform.position = instance.position;
+            transform.rotation =
+                glm::angleAxis(glm::radians(instance.rotation.x), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                glm::angleAxis(glm::radians(instance.rotation.y), glm::vec3(1.0f, 0.0f, 0.0f)) *
+                glm::angleAxis(glm::radians(instance.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+            transform.scale = glm::vec3(instance.scale);
+            Bounds bounds;
+            bounds.local_min = model.BoundsMin();
+            bounds.local_max = model.BoundsMax();
+            Entity entity = world_.CreateEntity();
+            world_.Transforms().Add(entity, transform);
+            world_.MeshRenderers().Add(entity, MeshRenderer{ instance.model });
+            world_.BoundsPool().Add(entity, bounds);
+            entities.push_back(entity);
+            // world bounds exist once UpdateBounds ran
+            added_static_entities_.push_back(entity);
+        }
+        for (const Light& light : event.data.lights) {
+            Entity entity = world_.CreateEntity();
+            world_.Transforms().Add(entity, Transform{ light.position });
+            world_.Lights().Add(entity, LightComponent{ light });
+            entities.push_back(entity);
+        }
+    }
+}
+
+void MofuWindow::AddStaticChange(Entity entity) {
+    if (!world_.MeshRenderers().Has(entity) || !world_.MeshRenderers().Get(entity).is_static ||
+        !world_.BoundsPool().Has(entity)) {
+        return;
+    }
+    const Bounds& bounds = world_.BoundsPool().Get(entity);
+    if (!static_change_pending_) {
+        pending_static_change_.bounds_min = bounds.world_min;
+        pending_static_change_.bounds_max = bounds.world_max;
+        static_change_pending_ = true;
+        return;
+    }
+    pending_static_change_.bounds_min = glm::min(pending_static_change_.bounds_min,
+        bounds.world_min);
+    pending_static_change_.bounds_max = glm::max(pending_static_change_.bounds_max,
+        bounds.world_max);
+}
+
+void MofuWindow::PublishStaticChanges(FrameSnapshot& snapshot) {
+    for (Entity entity : added_static_entities_) {
+        AddStaticChange(entity);
+    }
+    added_static_entities_.clear();
+    // everything that changed this frame becomes one revision
+    if (static_change_pending_) {
+        static_revision_++;
+        static_changes_[static_revision_ % FrameSnapshot::STATIC_CHANGE_NUM] =
+            pending_static_change_;
+        static_change_pending_ = false;
+    }
+    snapshot.static_revision = static_revision_;
+    std::copy(std::begin(static_changes_), std::end(static_changes_), snapshot.static_changes);
+}
+
+void MofuWindow::RotateFocus(float xoffset, float yoffset) {
+    focus_yaw_ += xoffset * FOCUS_SENSITIVITY;
+    focus_pitch_ = glm::clamp(focus_pitch_ + yoffset * FOCUS_SENSITIVITY, -89.0f, 89.0f);
+}
+
+glm::quat MofuWindow::FocusRotation(float yaw, float pitch) {
+    return glm::angleAxis(glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::angleAxis(glm::radians(-pitch), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+void MofuWindow::ReportOverdraw() {
+    if (!shaded_samples_ || shaded_samples_->ResolvedNum() == 0) {
+        return;
+    }
+    // samples shaded by the main pass per rendered pixel, 1.0 means no overdraw on full coverage
+    double pixel_num = static_cast<double>(rendered_pixel_sum_) / rendered_frame_num_;
+    double samples_per_pixel = static_cast<double>(shaded_samples_->TotalSamples()) /
+        (pixel_num * shaded_samples_->ResolvedNum());
+    std::cout << "Shaded samples per pixel: " << samples_per_pixel << " over " <<
+        shaded_samples_->ResolvedNum() << " frames (depth pre-pass " <<
+        (depth_prepass_ ? "on" : "off") << ", front to back " <<
+        (sort_front_to_back_ ? "on" : "off") << ")" << std::endl;
+
+    double frame_num = static_cast<double>(cull_frame_num_);
+    std::cout << "Meshes per frame: drawn " << drawn_mesh_num_ / frame_num <<
+        ", transparent " << transparent_mesh_sum_ / frame_num << ", frustum culled " <<
+        frustum_culled_num_ / frame_num << ", occluded " << occluded_num_ / frame_num << std::endl;
+}
+
+void MofuWindow::ReportShadows() {
+    if (shadow_frame_num_ == 0) {
+        return;
+    }
+    double frame_num = static_cast<double>(shadow_frame_num_);
+    std::cout << "Shadow casters per frame by cascade:";
+    for (uint64_t caster_sum : shadow_caster_sums_) {
+        std::cout << " " << caster_sum / frame_num;
+    }
+    std::cout << ", cascades drawn per frame " << shadow_render_sum_ / frame_num << std::endl;
+}
+
+void MofuWindow::BindCamera(const glm::mat4& view, const glm::mat4& projection) {
+    RingAllocation allocation = frame_data_->Allocate(2 * sizeof(glm::mat4),
+        static_cast<size_t>(uniform_alignment_));
+    if (!allocation.Valid()) {
+        return;
+    }
+    // std140 lays out mat4 members as four packed vec4 columns, the same as glm
+    std::memcpy(allocation.data, &view[0][0], sizeof(glm::mat4));
+    std::memcpy(static_cast<char*>(allocation.data) + sizeof(glm::mat4), &projection[0][0],
+        sizeof(glm::mat4));
+    frame_data_->Flush();
+    glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, allocation.buffer,
+        static_cast<GLintptr>(allocation.offset), static_cast<GLsizeiptr>(allocation.size));
+}
+
+void MofuWindow::ReportFrameData() {
+    if (frame_data_ == nullptr || frame_data_->FrameNum() == 0) {
+        return;
+    }
+    std::cout << "Frame data ring (" << (frame_data_->Persistent() ? "persistent" : "orphaned") <<
+        "): peak " << frame_data_->PeakUsage() << " of " << frame_data_->RegionSize() <<
+        " bytes per frame, " << frame_data_->StallNum() << " stalls (" <<
+        frame_data_->StallMilliseconds() << " ms), " << frame_data_->OverflowNum() <<
+        " overflows over " << frame_data_->FrameNum() << " frames" << std::endl;
+}
+
+void MofuWindow::ReportResolution() {
+    if (dynamic_resolution_ == nullptr || dynamic_resolution_->ResolvedNum() == 0) {
+        return;
+    }
+    std::cout << "Render scale: avg " << dynamic_resolution_->AverageScale() << ", lowest " <<
+        dynamic_resolution_->LowestScale() << ", scene GPU time avg " <<
+        dynamic_resolution_->AverageGpuMilliseconds() << " ms (target " << target_frame_ms_ <<
+        " ms)" << std::endl;
+}
+
+void MofuWindow::ReportLatency(std::chrono::steady_clock::time_point input_time) {
+    double latency_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - input_time).count();
+    latency_sum_ms_ += latency_ms;
+    latency_max_ms_ = std::max(latency_max_ms_, latency_ms);
+    latency_frame_num_++;
 }
 
 void MofuWindow::ProcessInput(GLFWwindow* window) {
+    float delta_time = timestep_.TickSeconds();
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
 
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-        camera_.ProcessKeyboard(CameraMovement::FORWARD, delta_time_);
+        camera_.ProcessKeyboard(CameraMovement::FORWARD, delta_time);
     }
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-        camera_.ProcessKeyboard(CameraMovement::BACKWARD, delta_time_);
+        camera_.ProcessKeyboard(CameraMovement::BACKWARD, delta_time);
     }
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-        camera_.ProcessKeyboard(CameraMovement::LEFT, delta_time_);
+        camera_.ProcessKeyboard(CameraMovement::LEFT, delta_time);
     }
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-        camera_.ProcessKeyboard(CameraMovement::RIGHT, delta_time_);
+        camera_.ProcessKeyboard(CameraMovement::RIGHT, delta_time);
     }
 }
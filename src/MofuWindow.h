@@ -1,9 +1,37 @@
 #ifndef SRC_MOFUWINDOW_H_
 #define SRC_MOFUWINDOW_H_
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "Camera.h"
+#include "CascadedShadowMap.h"
+#include "DynamicResolution.h"
+#include "Culling.h"
+#include "FrameSnapshot.h"
+#include "FrameTiming.h"
+#include "GpuRingBuffer.h"
+#include "JobSystem.h"
+#include "LightManager.h"
+#include "Model.h"
+#include "PassRecorder.h"
+#include "RenderTarget.h"
+#include "SampleCounter.h"
+#include "SceneFile.h"
+#include "SceneStreamer.h"
+#include "Shader.h"
+#include "TextureArray.h"
+#include "TransparencyPass.h"
+#include "TripleBuffer.h"
+#include "VirtualFileSystem.h"
+#include "World.h"
 
 class GLFWwindow;
 
@@ -13,12 +41,130 @@ public:
 	virtual ~MofuWindow() = default;
 
 	void ShowWindow();
+	void SetThreadedRender(bool threaded_render);
+	void SetVsync(bool vsync);
+	void SetMaxFps(double max_fps);
+	void SetDepthPrepass(bool depth_prepass);
+	void SetSortFrontToBack(bool sort_front_to_back);
+	void SetOcclusionCulling(bool occlusion_culling);
+	void SetUseTextureArray(bool use_texture_array);
+	void SetShadows(bool shadows);
+	void SetShadowBudget(int cascades_per_frame);
+	void SetDemoInstances(int instance_num);
+	void SetResourceRoot(const std::string& resource_root);
+	void SetScenePath(const std::string& scene_path);
+	void SetStreamingDataBudget(size_t bytes);
+	void AddPack(const std::string& pack_path);
+	void SetTargetFrameTime(double target_ms);
+	void SetMinResolutionScale(float min_scale);
 
 private:
 	void ProcessInput(GLFWwindow* window);
+	bool InitRenderer();
+	void UpdateFrame(GLFWwindow* window, FrameSnapshot& snapshot);
+	void RenderFrame(const FrameSnapshot& snapshot);
+	void RenderLoop(GLFWwindow* window);
+	void ReportLatency(std::chrono::steady_clock::time_point input_time);
+	void InitScene();
+	void ApplyStreamedChunks();
+	void AddStaticChange(Entity entity);
+	void PublishStaticChanges(FrameSnapshot& snapshot);
+	void RotateFocus(float xoffset, float yoffset);
+	static glm::quat FocusRotation(float yaw, float pitch);
+	void ReportOverdraw();
+	void BuildDrawLists(const FrameSnapshot& snapshot);
+	void RenderShadows(const FrameSnapshot& snapshot);
+	void RenderTransparent(const FrameSnapshot& snapshot, int width, int height);
+	void ReportShadows();
+	void BindCamera(const glm::mat4& view, const glm::mat4& projection);
+	void ReportFrameData();
+	void ReportResolution();
 
-	float delta_time_ = 0.0f;
-	float last_time_ = 0.0f;
+	JobSystem job_system_;
+	std::unique_ptr<Shader> shader_ = nullptr;
+	std::unique_ptr<Shader> depth_shader_ = nullptr;
+	std::unique_ptr<Shader> oit_composite_shader_ = nullptr;
+	// shared by every model, so equal textures are stored once and models share arrays
+	std::unique_ptr<TextureArrayPool> texture_arrays_ = nullptr;
+	std::vector<std::unique_ptr<Model>> models_ = {};
+	// every pass records into the same recorder once the previous one has replayed
+	PassRecorder pass_recorder_;
+	// one per pass, reset when the pass starts
+	CommandReplayer prepass_replayer_;
+	CommandReplayer scene_replayer_;
+	CommandReplayer shadow_replayer_;
+	CommandReplayer transparent_replayer_;
+	std::unique_ptr<SampleCounter> shaded_samples_ = nullptr;
+	std::unique_ptr<CascadedShadowMap> shadow_map_ = nullptr;
+	std::unique_ptr<GpuRingBuffer> frame_data_ = nullptr;
+	int uniform_alignment_ = 256;
+	std::unique_ptr<RenderTarget> scene_target_ = nullptr;
+	std::unique_ptr<DynamicResolution> dynamic_resolution_ = nullptr;
+	std::unique_ptr<TransparencyPass> transparency_ = nullptr;
+	double target_frame_ms_ = 1000.0 / 60.0;
+	float min_resolution_scale_ = 0.5f;
+	uint64_t rendered_pixel_sum_ = 0;
+	uint64_t rendered_frame_num_ = 0;
+	LightManager light_manager_;
+	World world_;
+	Entity focus_entity_ = {};
+	int demo_instance_num_ = 0;
+	std::string resource_root_ = "../../../..";
+	std::string scene_path_ = "resources/scene/demo.scene";
+	std::vector<std::string> pack_paths_ = {};
+	VirtualFileSystem vfs_;
+	SceneDescription scene_;
+	SceneStreamer streamer_;
+	std::vector<StreamedChunk> stream_events_ = {};
+	std::unordered_map<int, std::vector<Entity>> chunk_entities_ = {};
+	// static geometry changes for the cached shadow cascades, see FrameSnapshot
+	std::vector<Entity> added_static_entities_ = {};
+	StaticChange pending_static_change_ = {};
+	bool static_change_pending_ = false;
+	uint64_t static_revision_ = 0;
+	StaticChange static_changes_[FrameSnapshot::STATIC_CHANGE_NUM] = {};
+	std::atomic<bool> scene_ready_{false};
+	bool use_clustered_lights_ = true;
+	bool use_material_ = false;
+	bool use_texture_array_ = true;
+	bool depth_prepass_ = false;
+	bool sort_front_to_back_ = true;
+	bool occlusion_culling_ = true;
+	OcclusionBuffer occlusion_buffer_;
+	std::vector<OccluderCandidate> occluder_candidates_ = {};
+	std::vector<std::vector<unsigned int>> draw_lists_ = {};
+	std::vector<std::vector<unsigned int>> transparent_draw_lists_ = {};
+	size_t transparent_draw_num_ = 0;
+	uint64_t transparent_mesh_sum_ = 0;
+	uint64_t drawn_mesh_num_ = 0;
+	uint64_t frustum_culled_num_ = 0;
+	uint64_t occluded_num_ = 0;
+	uint64_t cull_frame_num_ = 0;
+	bool shadows_ = true;
+	int shadow_budget_ = CascadedShadowMap::FIRST_CACHED_CASCADE + 1;
+	uint64_t shadow_static_revision_ = 0;
+	// one per cascade and instance, they are recorded after all cascades are culled
+	std::vector<std::vector<unsigned int>> shadow_draw_lists_ = {};
+	uint64_t shadow_caster_sums_[CascadedShadowMap::CASCADE_NUM] = {};
+	uint64_t shadow_render_sum_ = 0;
+	uint64_t shadow_frame_num_ = 0;
+	bool threaded_render_ = false;
+	bool vsync_ = true;
+	std::atomic<bool> running_{false};
+	TripleBuffer<FrameSnapshot> snapshots_;
+	uint64_t frame_index_ = 0;
+	FixedTimestep timestep_;
+	FramePacer pacer_{DEFAULT_MAX_FPS};
+	Camera previous_camera_ = camera_;
+	float focus_yaw_ = 0.0f;
+	float focus_pitch_ = 0.0f;
+	float previous_focus_yaw_ = 0.0f;
+	float previous_focus_pitch_ = 0.0f;
+	float pending_xoffset_ = 0.0f;
+	float pending_yoffset_ = 0.0f;
+	double latency_sum_ms_ = 0.0;
+	double latency_max_ms_ = 0.0;
+	uint64_t latency_frame_num_ = 0;
 
 	static bool mouse_pressed_;
 	static float last_x_;
@@ -27,6 +173,14 @@ private:
 	static constexpr int SCR_WIDTH = 800;
 	static constexpr int SCR_HEIGHT = 600;
 	static constexpr char WINDOW_NAME[] = "MofuEngine";
+	static constexpr double DEFAULT_MAX_FPS = 240.0;
+	static constexpr float Z_NEAR = 0.1f;
+	static constexpr float Z_FAR = 100.0f;
+	static constexpr float FOCUS_SENSITIVITY = 0.1f;
+	// occluders rasterized per frame, picked by screen area over every visible instance
+	static constexpr size_t MAX_OCCLUDERS = 8;
+	static constexpr unsigned int CAMERA_BINDING = 0;
+	static constexpr size_t FRAME_DATA_REGION_SIZE = 64 * 1024;
 };
 
 #endif  // SRC_MOFUWINDOW_H_
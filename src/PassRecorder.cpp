@@ -0,0 +1,61 @@
+#include "PassRecorder.h"
+
+#include <algorithm>
+
+void PassRecorder::Clear() {
+    chunks_.clear();
+}
+
+void PassRecorder::Add(Model& model, const glm::mat4& transform,
+    const std::vector<unsigned int>& draw_list) {
+    for (size_t begin = 0; begin < draw_list.size(); begin += RECORD_GRAIN) {
+        size_t mesh_num = std::min(RECORD_GRAIN, draw_list.size() - begin);
+        chunks_.push_back(Chunk{ &model, transform, &draw_list[begin], mesh_num });
+    }
+}
+
+void PassRecorder::Record(JobSystem* jobs, const Shader& shader, bool use_material) {
+    for (const Chunk& chunk : chunks_) {
+        chunk.model->PrepareRecord(shader);
+    }
+    RecordChunks(jobs, [use_material](const Chunk& chunk, CommandBuffer& commands) {
+        chunk.model->Record(commands, chunk.transform, use_material, chunk.meshes,
+            chunk.mesh_num);
+    });
+}
+
+void PassRecorder::RecordDepth(JobSystem* jobs, const Shader& shader) {
+    int model_location = shader.Location("model");
+    RecordChunks(jobs, [model_location](const Chunk& chunk, CommandBuffer& commands) {
+        chunk.model->RecordDepth(commands, model_location, chunk.transform, chunk.meshes,
+            chunk.mesh_num);
+    });
+}
+
+void PassRecorder::Replay(CommandReplayer& replayer, size_t first, size_t last) const {
+    for (size_t i = first; i < last; i++) {
+        replayer.Replay(buffers_[i]);
+    }
+}
+
+void PassRecorder::Replay(CommandReplayer& replayer) const {
+    Replay(replayer, 0, chunks_.size());
+}
+
+void PassRecorder::RecordChunks(JobSystem* jobs,
+    const std::function<void(const Chunk&, CommandBuffer&)>& record_chunk) {
+    if (buffers_.size() < chunks_.size()) {
+        buffers_.resize(chunks_.size());
+    }
+    auto record = [this, &record_chunk](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            buffers_[i].Reset();
+            record_chunk(chunks_[i], buffers_[i]);
+        }
+    };
+    if (jobs) {
+        jobs->ParallelFor(chunks_.size(), 1, record);
+    } else {
+        record(0, chunks_.size());
+    }
+}
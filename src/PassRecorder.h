@@ -0,0 +1,59 @@
+#ifndef SRC_PASSRECORDER_H_
+#define SRC_PASSRECORDER_H_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "CommandBuffer.h"
+#include "CommandReplayer.h"
+#include "JobSystem.h"
+#include "Model.h"
+#include "Shader.h"
+
+// Collects the draws of one pass, records them into command buffers across the job system and
+// replays them on the context thread in a single loop. Each draw is split into chunks of at most
+// RECORD_GRAIN meshes, so a single large model still records in parallel. Draw lists are
+// referenced, not copied, and must stay untouched until recording is done.
+class PassRecorder {
+public:
+    PassRecorder() = default;
+    ~PassRecorder() = default;
+    PassRecorder(const PassRecorder&) = delete;
+    PassRecorder& operator=(const PassRecorder&) = delete;
+
+    void Clear();
+    void Add(Model& model, const glm::mat4& transform, const std::vector<unsigned int>& draw_list);
+    // uniform locations are resolved on the calling thread, which must own the context
+    void Record(JobSystem* jobs, const Shader& shader, bool use_material);
+    void RecordDepth(JobSystem* jobs, const Shader& shader);
+    // replays chunks [first, last), ChunkNum() taken between Add() calls marks a range
+    void Replay(CommandReplayer& replayer, size_t first, size_t last) const;
+    void Replay(CommandReplayer& replayer) const;
+    inline size_t ChunkNum() const;
+
+    static constexpr size_t RECORD_GRAIN = 64;
+
+private:
+    struct Chunk {
+        Model* model;
+        glm::mat4 transform;
+        const unsigned int* meshes;
+        size_t mesh_num;
+    };
+
+    void RecordChunks(JobSystem* jobs,
+        const std::function<void(const Chunk&, CommandBuffer&)>& record_chunk);
+
+    std::vector<Chunk> chunks_ = {};
+    // only ever grows, so buffers keep their memory from frame to frame
+    std::vector<CommandBuffer> buffers_ = {};
+};
+
+size_t PassRecorder::ChunkNum() const {
+    return chunks_.size();
+}
+
+#endif  // SRC_PASSRECORDER_H_
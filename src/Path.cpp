@@ -0,0 +1,51 @@
+#include "Path.h"
+
+#include <algorithm>
+#include <vector>
+
+std::string NormalizePath(const std::string& path) {
+    std::string slashed = path;
+    std::replace(slashed.begin(), slashed.end(), '\\', '/');
+
+    std::vector<std::string> segments;
+    size_t begin = 0;
+    while (begin <= slashed.size()) {
+        size_t end = slashed.find('/', begin);
+        if (end == std::string::npos) {
+            end = slashed.size();
+        }
+        std::string segment = slashed.substr(begin, end - begin);
+        begin = end + 1;
+        if (segment == "." || (segment.empty() && !segments.empty())) {
+            continue;
+        }
+        if (segment == ".." && !segments.empty() && segments.back() != ".." &&
+            !segments.back().empty()) {
+            segments.pop_back();
+            continue;
+        }
+        segments.push_back(segment);
+    }
+
+    std::string normalized;
+    for (size_t i = 0; i < segments.size(); i++) {
+        normalized += i == 0 ? segments[i] : "/" + segments[i];
+    }
+    return normalized;
+}
+
+std::string JoinPath(const std::string& directory, const std::string& name) {
+    std::string normalized = NormalizePath(name);
+    bool absolute = !normalized.empty() && (normalized[0] == '/' ||
+        (normalized.size() > 1 && normalized[1] == ':'));
+    if (directory.empty() || absolute) {
+        return normalized;
+    }
+    return NormalizePath(directory + '/' + normalized);
+}
+
+std::string ParentPath(const std::string& path) {
+    std::string normalized = NormalizePath(path);
+    size_t separator = normalized.find_last_of('/');
+    return separator == std::string::npos ? std::string() : normalized.substr(0, separator);
+}
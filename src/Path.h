@@ -0,0 +1,13 @@
+#ifndef SRC_PATH_H_
+#define SRC_PATH_H_
+
+#include <string>
+
+// Paths are kept with '/' separators, which every supported platform accepts. Backslashes from
+// Windows authored assets are converted on the way in, and "." and "dir/.." segments are
+// collapsed so the same file always gets the same spelling.
+std::string NormalizePath(const std::string& path);
+std::string JoinPath(const std::string& directory, const std::string& name);
+std::string ParentPath(const std::string& path);
+
+#endif  // SRC_PATH_H_
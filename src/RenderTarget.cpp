@@ -0,0 +1,76 @@
+#include "RenderTarget.h"
+
+#include <iostream>
+
+#include <GL/glew.h>
+
+RenderTarget::~RenderTarget() {
+    Release();
+}
+
+bool RenderTarget::Resize(int width, int height) {
+    if (fbo_ != 0 && width == width_ && height == height_) {
+        return true;
+    }
+    Release();
+    width_ = width;
+    height_ = height;
+
+    glGenTextures(1, &color_texture_);
+    glBindTexture(GL_TEXTURE_2D, color_texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+        nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &depth_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_, height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture_, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+        depth_buffer_);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cout << "ERROR::RENDER_TARGET::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        Release();
+        return false;
+    }
+    return true;
+}
+
+void RenderTarget::Bind(int viewport_width, int viewport_height) const {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, viewport_width, viewport_height);
+}
+
+void RenderTarget::BlitToScreen(int source_width, int source_height, int screen_width,
+    int screen_height) const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    // bilinear only when actually scaling, a 1:1 copy stays sharp
+    GLenum filter = source_width == screen_width && source_height == screen_height ?
+        GL_NEAREST : GL_LINEAR;
+    glBlitFramebuffer(0, 0, source_width, source_height, 0, 0, screen_width, screen_height,
+        GL_COLOR_BUFFER_BIT, filter);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::Release() {
+    if (fbo_ == 0) {
+        return;
+    }
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteRenderbuffers(1, &depth_buffer_);
+    glDeleteTextures(1, &color_texture_);
+    fbo_ = 0;
+    depth_buffer_ = 0;
+    color_texture_ = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef SRC_RENDERTARGET_H_
+#define SRC_RENDERTARGET_H_
+
+// Offscreen color + depth framebuffer the scene is drawn into. Storage is sized to the window;
+// lower render resolutions only draw into the bottom left corner, so changing the resolution
+// never reallocates, and BlitToScreen scales that corner up to the window.
+class RenderTarget {
+public:
+    RenderTarget() = default;
+    ~RenderTarget();
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    bool Resize(int width, int height);
+    void Bind(int viewport_width, int viewport_height) const;
+    void BlitToScreen(int source_width, int source_height, int screen_width,
+        int screen_height) const;
+    inline int Width() const;
+    inline int Height() const;
+    inline unsigned int DepthBuffer() const;
+
+private:
+    void Release();
+
+    unsigned int fbo_ = 0;
+    unsigned int color_texture_ = 0;
+    unsigned int depth_buffer_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+int RenderTarget::Width() const {
+    return width_;
+}
+
+int RenderTarget::Height() const {
+    return height_;
+}
+
+unsigned int RenderTarget::DepthBuffer() const {
+    return depth_buffer_;
+}
+
+#endif  // SRC_RENDERTARGET_H_
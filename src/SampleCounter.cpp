@@ -0,0 +1,46 @@
+#include "SampleCounter.h"
+
+#include <GL/glew.h>
+
+SampleCounter::~SampleCounter() {
+    if (queries_[0] != 0) {
+        glDeleteQueries(QUERY_NUM, queries_);
+    }
+}
+
+void SampleCounter::Begin() {
+    if (queries_[0] == 0) {
+        glGenQueries(QUERY_NUM, queries_);
+    }
+    // the oldest query is reused, so it has to be resolved first; normally it is long done
+    if (pending_[current_]) {
+        Collect(current_, true);
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, queries_[current_]);
+}
+
+void SampleCounter::End() {
+    glEndQuery(GL_SAMPLES_PASSED);
+    pending_[current_] = true;
+    current_ = (current_ + 1) % QUERY_NUM;
+    for (int i = 0; i < QUERY_NUM; i++) {
+        if (pending_[i]) {
+            Collect(i, false);
+        }
+    }
+}
+
+void SampleCounter::Collect(int query, bool wait) {
+    if (!wait) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries_[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            return;
+        }
+    }
+    GLuint samples = 0;
+    glGetQueryObjectuiv(queries_[query], GL_QUERY_RESULT, &samples);
+    total_samples_ += samples;
+    resolved_num_++;
+    pending_[query] = false;
+}
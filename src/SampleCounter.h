@@ -0,0 +1,39 @@
+#ifndef SRC_SAMPLECOUNTER_H_
+#define SRC_SAMPLECOUNTER_H_
+
+#include <cstdint>
+
+// Counts the samples that pass the depth test between Begin and End with GL_SAMPLES_PASSED
+// queries. Results are read back a few frames late from a small query ring so the CPU never
+// waits on the GPU.
+class SampleCounter {
+public:
+    SampleCounter() = default;
+    ~SampleCounter();
+
+    void Begin();
+    void End();
+    inline uint64_t TotalSamples() const;
+    inline uint64_t ResolvedNum() const;
+
+    static constexpr int QUERY_NUM = 4;
+
+private:
+    void Collect(int query, bool wait);
+
+    unsigned int queries_[QUERY_NUM] = {};
+    bool pending_[QUERY_NUM] = {};
+    int current_ = 0;
+    uint64_t total_samples_ = 0;
+    uint64_t resolved_num_ = 0;
+};
+
+uint64_t SampleCounter::TotalSamples() const {
+    return total_samples_;
+}
+
+uint64_t SampleCounter::ResolvedNum() const {
+    return resolved_num_;
+}
+
+#endif  // SRC_SAMPLECOUNTER_H_
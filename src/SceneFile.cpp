@@ -0,0 +1,118 @@
+#include "SceneFile.h"
+
+#include <iostream>
+#include <sstream>
+
+#include "Path.h"
+
+namespace {
+
+// Calls parse_line for each non-empty, non-comment line of the file and stops at the
+// first line it rejects.
+template <typename Func>
+bool ForEachLine(const VirtualFileSystem& vfs, const std::string& path, const Func& parse_line) {
+    FileView file = vfs.Open(path);
+    if (!file.Valid()) {
+        std::cout << "ERROR::SCENE::FILE_NOT_FOUND " << path << std::endl;
+        return false;
+    }
+    const char* cursor = file.Data();
+    const char* end = cursor + file.Size();
+    int line_number = 0;
+    while (cursor < end) {
+        const char* line_end = cursor;
+        while (line_end < end && *line_end != '\n') {
+            line_end++;
+        }
+        std::string line(cursor, line_end);
+        cursor = line_end + 1;
+        line_number++;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword)) {
+            continue;
+        }
+        if (!parse_line(keyword, fields)) {
+            std::cout << "ERROR::SCENE::PARSE_FAILED " << path << ":" << line_number <<
+                std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool LoadSceneDescription(const VirtualFileSystem& vfs, const std::string& path,
+    SceneDescription& scene) {
+    std::string directory = ParentPath(path);
+    return ForEachLine(vfs, path, [&](const std::string& keyword, std::istringstream& fields) {
+        if (keyword == "chunk_size") {
+            return static_cast<bool>(fields >> scene.chunk_size) && scene.chunk_size > 0.0f;
+        }
+        if (keyword == "model") {
+            SceneModel model;
+            if (!(fields >> model.path)) {
+                return false;
+            }
+            model.path = JoinPath(directory, model.path);
+            if (fields >> model.texture_path) {
+                model.texture_path = JoinPath(directory, model.texture_path);
+            }
+            scene.models.push_back(model);
+            return true;
+        }
+        if (keyword == "chunk") {
+            SceneChunk chunk;
+            if (!(fields >> chunk.x >> chunk.z >> chunk.path)) {
+                return false;
+            }
+            chunk.path = JoinPath(directory, chunk.path);
+            scene.chunks.push_back(chunk);
+            return true;
+        }
+        return false;
+    });
+}
+
+bool LoadChunk(const VirtualFileSystem& vfs, const std::string& path, ChunkData& chunk) {
+    return ForEachLine(vfs, path, [&chunk](const std::string& keyword, std::istringstream& fields) {
+        if (keyword == "instance") {
+            SceneInstance instance;
+            fields >> instance.model >> instance.position.x >> instance.position.y >>
+                instance.position.z >> instance.rotation.x >> instance.rotation.y >>
+                instance.rotation.z >> instance.scale;
+            chunk.instances.push_back(instance);
+            return !fields.fail();
+        }
+        if (keyword == "light") {
+            std::string type;
+            Light light;
+            fields >> type >> light.position.x >> light.position.y >> light.position.z;
+            if (type == "spot") {
+                light.type = LightType::SPOT;
+                fields >> light.direction.x >> light.direction.y >> light.direction.z;
+            } else if (type != "point") {
+                return false;
+            }
+            fields >> light.color.x >> light.color.y >> light.color.z >> light.intensity >>
+                light.range;
+            if (light.type == LightType::SPOT) {
+                fields >> light.inner_angle >> light.outer_angle;
+            }
+            chunk.lights.push_back(light);
+            return !fields.fail();
+        }
+        return false;
+    });
+}
+
+size_t ChunkMemory(const ChunkData& chunk) {
+    return sizeof(ChunkData) + chunk.instances.capacity() * sizeof(SceneInstance) +
+        chunk.lights.capacity() * sizeof(Light);
+}
@@ -0,0 +1,61 @@
+#ifndef SRC_SCENEFILE_H_
+#define SRC_SCENEFILE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "LightManager.h"
+#include "VirtualFileSystem.h"
+
+// Scene files are plain text with one record per line, '#' starts a comment. Paths are relative
+// to the file that names them and always use '/'.
+//
+// Scene index (*.scene):
+//   chunk_size <size>
+//   model <model path> [fixed texture path]
+//   chunk <x> <z> <chunk path>
+//
+// A chunk covers [x * size, (x + 1) * size) by [z * size, (z + 1) * size) on the ground plane:
+//   instance <model> <px> <py> <pz> <yaw> <pitch> <roll> <scale>
+//   light point <px> <py> <pz> <r> <g> <b> <intensity> <range>
+//   light spot <px> <py> <pz> <dx> <dy> <dz> <r> <g> <b> <intensity> <range> <inner> <outer>
+
+struct SceneModel {
+    std::string path;
+    std::string texture_path;
+};
+
+struct SceneChunk {
+    int x = 0;
+    int z = 0;
+    std::string path;
+};
+
+struct SceneDescription {
+    float chunk_size = 32.0f;
+    std::vector<SceneModel> models = {};
+    std::vector<SceneChunk> chunks = {};
+};
+
+struct SceneInstance {
+    unsigned int model = 0;
+    glm::vec3 position = glm::vec3(0.0f);
+    // degrees
+    glm::vec3 rotation = glm::vec3(0.0f);
+    float scale = 1.0f;
+};
+
+struct ChunkData {
+    std::vector<SceneInstance> instances = {};
+    std::vector<Light> lights = {};
+};
+
+bool LoadSceneDescription(const VirtualFileSystem& vfs, const std::string& path,
+    SceneDescription& scene);
+bool LoadChunk(const VirtualFileSystem& vfs, const std::string& path, ChunkData& chunk);
+size_t ChunkMemory(const ChunkData& chunk);
+
+#endif  // SRC_SCENEFILE_H_
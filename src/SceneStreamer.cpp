@@ -0,0 +1,148 @@
+#include "SceneStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+SceneStreamer::~SceneStreamer() {
+    Stop();
+}
+
+void SceneStreamer::Start(const SceneDescription& scene, const VirtualFileSystem& vfs) {
+    Stop();
+    scene_ = scene;
+    vfs_ = &vfs;
+    chunk_bytes_.assign(scene_.chunks.size(), 0);
+    resident_data_bytes_ = 0;
+    resident_chunk_num_ = 0;
+    stop_ = false;
+    thread_ = std::thread([this]() {
+        Run();
+    });
+}
+
+void SceneStreamer::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void SceneStreamer::SetViewer(const glm::vec3& position) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        viewer_ = position;
+    }
+    wake_.notify_one();
+}
+
+void SceneStreamer::SetLoadRadius(float radius) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    load_radius_ = radius;
+}
+
+void SceneStreamer::SetDataBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_budget_ = bytes;
+}
+
+void SceneStreamer::Poll(std::vector<StreamedChunk>& events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events.clear();
+    events.swap(events_);
+}
+
+float SceneStreamer::DistanceTo(int chunk, const glm::vec3& viewer) const {
+    // distance on the ground plane from the viewer to the nearest point of the chunk square
+    float size = scene_.chunk_size;
+    float min_x = scene_.chunks[chunk].x * size;
+    float min_z = scene_.chunks[chunk].z * size;
+    float dx = std::max(std::max(min_x - viewer.x, viewer.x - (min_x + size)), 0.0f);
+    float dz = std::max(std::max(min_z - viewer.z, viewer.z - (min_z + size)), 0.0f);
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void SceneStreamer::Run() {
+    std::vector<std::pair<float, int>> order;
+    while (true) {
+        glm::vec3 viewer;
+        float load_radius = 0.0f;
+        size_t data_budget = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // also wakes up periodically so a missed notify only delays streaming a little
+            wake_.wait_for(lock, std::chrono::milliseconds(100));
+            if (stop_) {
+                return;
+            }
+            viewer = viewer_;
+            load_radius = load_radius_;
+            data_budget = data_budget_;
+        }
+
+        order.clear();
+        for (size_t i = 0; i < scene_.chunks.size(); i++) {
+            order.emplace_back(DistanceTo(static_cast<int>(i), viewer), static_cast<int>(i));
+        }
+        std::sort(order.begin(), order.end());
+
+        auto release = [this](int chunk) {
+            resident_data_bytes_ -= chunk_bytes_[chunk];
+            resident_chunk_num_--;
+            chunk_bytes_[chunk] = 0;
+            StreamedChunk event;
+            event.chunk = chunk;
+            std::lock_guard<std::mutex> lock(mutex_);
+            events_.push_back(std::move(event));
+        };
+        // hysteresis between load and unload radius avoids thrashing at the border
+        for (const std::pair<float, int>& entry : order) {
+            if (chunk_bytes_[entry.second] != 0 && entry.first > load_radius * UNLOAD_FACTOR) {
+                release(entry.second);
+            }
+        }
+
+        size_t farthest = order.size();
+        for (size_t i = 0; i < farthest && order[i].first <= load_radius; i++) {
+            int chunk = order[i].second;
+            if (chunk_bytes_[chunk] != 0) {
+                continue;
+            }
+            StreamedChunk streamed;
+            streamed.chunk = chunk;
+            streamed.loaded = true;
+            if (!LoadChunk(*vfs_, scene_.chunks[chunk].path, streamed.data)) {
+                // kept as resident with a token size so a broken file is not retried every pass
+                chunk_bytes_[chunk] = 1;
+                resident_data_bytes_ += 1;
+                resident_chunk_num_++;
+                continue;
+            }
+            size_t bytes = ChunkMemory(streamed.data);
+            // make room by dropping resident chunks farther away than this one
+            while (resident_data_bytes_ + bytes > data_budget && farthest > i + 1) {
+                farthest--;
+                if (chunk_bytes_[order[farthest].second] != 0) {
+                    release(order[farthest].second);
+                }
+            }
+            if (resident_data_bytes_ + bytes > data_budget) {
+                break;
+            }
+            chunk_bytes_[chunk] = bytes;
+            resident_data_bytes_ += bytes;
+            resident_chunk_num_++;
+            std::lock_guard<std::mutex> lock(mutex_);
+            events_.push_back(std::move(streamed));
+            if (stop_) {
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SRC_SCENESTREAMER_H_
+#define SRC_SCENESTREAMER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SceneFile.h"
+
+// A chunk that became resident (with its data) or was released, in the order it happened.
+struct StreamedChunk {
+    int chunk = -1;
+    bool loaded = false;
+    ChunkData data = {};
+};
+
+// Loads the chunks of a scene around a viewer on a background thread. Chunks within the load
+// radius are read nearest first while the resident total stays under the data budget; chunks
+// beyond the unload radius, or the farthest ones when the budget is needed for nearer chunks,
+// are released again. The owner applies the events on its own thread through Poll.
+// The data budget bounds only the parsed chunk data (see ChunkMemory). The models, textures and
+// GPU buffers the instances use are loaded with the scene description, stay resident for the
+// whole run and are not part of it.
+class SceneStreamer {
+public:
+    SceneStreamer() = default;
+    ~SceneStreamer();
+
+    void Start(const SceneDescription& scene, const VirtualFileSystem& vfs);
+    void Stop();
+    void SetViewer(const glm::vec3& position);
+    void SetLoadRadius(float radius);
+    void SetDataBudget(size_t bytes);
+    void Poll(std::vector<StreamedChunk>& events);
+    inline size_t ResidentDataBytes() const;
+    inline size_t ResidentChunkNum() const;
+
+private:
+    void Run();
+    float DistanceTo(int chunk, const glm::vec3& viewer) const;
+
+    SceneDescription scene_ = {};
+    const VirtualFileSystem* vfs_ = nullptr;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    glm::vec3 viewer_ = glm::vec3(0.0f);
+    float load_radius_ = 64.0f;
+    size_t data_budget_ = 16 * 1024 * 1024;
+    std::vector<StreamedChunk> events_ = {};
+
+    // owned by the streaming thread
+    std::vector<size_t> chunk_bytes_ = {};
+    std::atomic<size_t> resident_data_bytes_{0};
+    std::atomic<size_t> resident_chunk_num_{0};
+
+    static constexpr float UNLOAD_FACTOR = 1.25f;
+};
+
+size_t SceneStreamer::ResidentDataBytes() const {
+    return resident_data_bytes_;
+}
+
+size_t SceneStreamer::ResidentChunkNum() const {
+    return resident_chunk_num_;
+}
+
+#endif  // SRC_SCENESTREAMER_H_
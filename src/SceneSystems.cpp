@@ -0,0 +1,111 @@
+#include "SceneSystems.h"
+
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Culling.h"
+
+namespace {
+
+constexpr size_t SYSTEM_GRAIN = 1024;
+
+template <typename Func>
+void ForEachRange(size_t count, JobSystem* jobs, const Func& func) {
+    if (jobs) {
+        jobs->ParallelFor(count, SYSTEM_GRAIN, func);
+    } else {
+        func(0, count);
+    }
+}
+
+}  // namespace
+
+glm::mat4 TransformMatrix(const Transform& transform) {
+    return glm::scale(glm::translate(glm::mat4(1.0f), transform.position) *
+        glm::mat4_cast(transform.rotation), transform.scale);
+}
+
+void UpdateTransforms(World& world, JobSystem* jobs) {
+    Transform* transforms = world.Transforms().Data();
+    ForEachRange(world.Transforms().Size(), jobs, [transforms](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            transforms[i].world = TransformMatrix(transforms[i]);
+        }
+    });
+}
+
+void UpdateBounds(World& world, JobSystem* jobs) {
+    Bounds* bounds = world.BoundsPool().Data();
+    const Entity* entities = world.BoundsPool().Entities();
+    const ComponentPool<Transform>& transforms = world.Transforms();
+    ForEachRange(world.BoundsPool().Size(), jobs, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (!transforms.Has(entities[i])) {
+                continue;
+            }
+            // world box of a transformed box: moved center plus the extent through |M|
+            const glm::mat4& m = transforms.Get(entities[i]).world;
+            glm::vec3 center = (bounds[i].local_min + bounds[i].local_max) * 0.5f;
+            glm::vec3 extent = (bounds[i].local_max - bounds[i].local_min) * 0.5f;
+            glm::vec3 world_center = glm::vec3(m * glm::vec4(center, 1.0f));
+            glm::vec3 world_extent(0.0f);
+            for (int axis = 0; axis < 3; axis++) {
+                world_extent[axis] = std::abs(m[0][axis]) * extent.x +
+                    std::abs(m[1][axis]) * extent.y + std::abs(m[2][axis]) * extent.z;
+            }
+            bounds[i].world_min = world_center - world_extent;
+            bounds[i].world_max = world_center + world_extent;
+        }
+    });
+}
+
+void CollectRenderables(const World& world, const glm::mat4& view_projection, JobSystem* jobs,
+    FrameSnapshot& snapshot) {
+    const ComponentPool<MeshRenderer>& renderers = world.MeshRenderers();
+    const ComponentPool<Transform>& transforms = world.Transforms();
+    const ComponentPool<Bounds>& bounds = world.BoundsPool();
+    const Entity* entities = renderers.Entities();
+    size_t renderer_num = renderers.Size();
+
+    snapshot.instance_transforms.resize(renderer_num);
+    snapshot.instance_models.resize(renderer_num);
+    snapshot.instance_casts_shadows.resize(renderer_num);
+    snapshot.instance_static.resize(renderer_num);
+    // one flag per instance so the parallel pass never writes to a shared list
+    std::vector<unsigned char> visible(renderer_num);
+    Frustum frustum(view_projection);
+    ForEachRange(renderer_num, jobs, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Entity entity = entities[i];
+            const MeshRenderer& renderer = renderers.Data()[i];
+            snapshot.instance_transforms[i] = transforms.Has(entity) ?
+                transforms.Get(entity).world : glm::mat4(1.0f);
+            snapshot.instance_models[i] = renderer.model;
+            snapshot.instance_casts_shadows[i] = renderer.casts_shadows;
+            snapshot.instance_static[i] = renderer.is_static;
+            visible[i] = !bounds.Has(entity) ||
+                frustum.Intersects(bounds.Get(entity).world_min, bounds.Get(entity).world_max);
+        }
+    });
+
+    snapshot.visible_instances.clear();
+    for (size_t i = 0; i < renderer_num; i++) {
+        if (visible[i]) {
+            snapshot.visible_instances.push_back(static_cast<unsigned int>(i));
+        }
+    }
+}
+
+void CollectLights(const World& world, std::vector<Light>& lights) {
+    const ComponentPool<LightComponent>& light_pool = world.Lights();
+    const ComponentPool<Transform>& transforms = world.Transforms();
+    lights.resize(light_pool.Size());
+    for (size_t i = 0; i < light_pool.Size(); i++) {
+        Entity entity = light_pool.Entities()[i];
+        lights[i] = light_pool.Data()[i].light;
+        if (transforms.Has(entity)) {
+            lights[i].position = transforms.Get(entity).position;
+        }
+    }
+}
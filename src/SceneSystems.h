@@ -0,0 +1,24 @@
+#ifndef SRC_SCENESYSTEMS_H_
+#define SRC_SCENESYSTEMS_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "FrameSnapshot.h"
+#include "JobSystem.h"
+#include "LightManager.h"
+#include "World.h"
+
+// translation * rotation * scale, the matrix UpdateTransforms stores in Transform::world
+glm::mat4 TransformMatrix(const Transform& transform);
+
+// Systems walk the packed component arrays of a World front to back and split them across the
+// job system when one is given.
+void UpdateTransforms(World& world, JobSystem* jobs);
+void UpdateBounds(World& world, JobSystem* jobs);
+void CollectRenderables(const World& world, const glm::mat4& view_projection, JobSystem* jobs,
+    FrameSnapshot& snapshot);
+void CollectLights(const World& world, std::vector<Light>& lights);
+
+#endif  // SRC_SCENESYSTEMS_H_
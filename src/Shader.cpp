@@ -1,60 +1,47 @@
 #include "Shader.h"
 
-#include <fstream>
 #include <iostream>
-#include <sstream>
 
 #include <GL/glew.h>
 
-Shader::Shader(const char* vertex_path, const char* fragment_path, const char* geometry_path) {
-    std::string vertex_code;
-    std::string fragment_code;
-    std::string geometry_code;
-    std::ifstream v_shader_file;
-    std::ifstream f_shader_file;
-    std::ifstream g_shader_file;
-    v_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    f_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    g_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try {
-        v_shader_file.open(vertex_path);
-        f_shader_file.open(fragment_path);
-        std::stringstream v_shader_stream;
-        std::stringstream f_shader_stream;
-        v_shader_stream << v_shader_file.rdbuf();
-        f_shader_stream << f_shader_file.rdbuf();
-        v_shader_file.close();
-        f_shader_file.close();
-        vertex_code = v_shader_stream.str();
-        fragment_code = f_shader_stream.str();
-        if (geometry_path != nullptr) {
-            g_shader_file.open(geometry_path);
-            std::stringstream g_shader_stream;
-            g_shader_stream << g_shader_file.rdbuf();
-            g_shader_file.close();
-            geometry_code = g_shader_stream.str();
-        }
-    } catch (std::ifstream::failure& e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+Shader::Shader(const char* vertex_path, const char* fragment_path, const char* geometry_path,
+    const VirtualFileSystem* vfs) {
+    // without a mounted file system sources come straight from disk
+    static const VirtualFileSystem loose_files;
+    const VirtualFileSystem& files = vfs != nullptr ? *vfs : loose_files;
+    FileView vertex_file = files.Open(vertex_path);
+    FileView fragment_file = files.Open(fragment_path);
+    FileView geometry_file;
+    if (geometry_path != nullptr) {
+        geometry_file = files.Open(geometry_path);
     }
-    const char* v_shader_code = vertex_code.c_str();
-    const char* f_shader_code = fragment_code.c_str();
+    if (!vertex_file.Valid() || !fragment_file.Valid() ||
+        (geometry_path != nullptr && !geometry_file.Valid())) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << vertex_path << " " <<
+            fragment_path << std::endl;
+    }
+    // the views are handed to GL with explicit lengths, no terminated copies are needed
+    const char* v_shader_code = vertex_file.Valid() ? vertex_file.Data() : "";
+    const char* f_shader_code = fragment_file.Valid() ? fragment_file.Data() : "";
+    GLint v_shader_length = static_cast<GLint>(vertex_file.Size());
+    GLint f_shader_length = static_cast<GLint>(fragment_file.Size());
     unsigned int vertex = 0;
     unsigned int fragment = 0;
     vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &v_shader_code, NULL);
+    glShaderSource(vertex, 1, &v_shader_code, &v_shader_length);
     glCompileShader(vertex);
     CheckCompileErrors(vertex, "VERTEX");
     fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &f_shader_code, NULL);
+    glShaderSource(fragment, 1, &f_shader_code, &f_shader_length);
     glCompileShader(fragment);
     CheckCompileErrors(fragment, "FRAGMENT");
     unsigned int geometry;
     if (geometry_path != nullptr)
     {
-        const char* g_shader_code = geometry_code.c_str();
+        const char* g_shader_code = geometry_file.Valid() ? geometry_file.Data() : "";
+        GLint g_shader_length = static_cast<GLint>(geometry_file.Size());
         geometry = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(geometry, 1, &g_shader_code, NULL);
+        glShaderSource(geometry, 1, &g_shader_code, &g_shader_length);
         glCompileShader(geometry);
         CheckCompileErrors(geometry, "GEOMETRY");
     }
@@ -66,6 +53,7 @@ Shader::Shader(const char* vertex_path, const char* fragment_path, const char* g
     }
     glLinkProgram(id_);
     CheckCompileErrors(id_, "PROGRAM");
+    CacheUniformLocations();
     glDeleteShader(vertex);
     glDeleteShader(fragment);
     if (geometry_path != nullptr) {
@@ -78,51 +66,74 @@ void Shader::Use() {
 }
 
 void Shader::SetBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(id_, name.c_str()), static_cast<int>(value));
+    glUniform1i(Location(name), static_cast<int>(value));
 }
 
 void Shader::SetInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(id_, name.c_str()), value);
+    glUniform1i(Location(name), value);
 }
 
 void Shader::SetFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(id_, name.c_str()), value);
+    glUniform1f(Location(name), value);
 }
 
 void Shader::SetVec2(const std::string& name, const glm::vec2& value) const {
-    glUniform2fv(glGetUniformLocation(id_, name.c_str()), 1, &value[0]);
+    glUniform2fv(Location(name), 1, &value[0]);
 }
 
 void Shader::SetVec2(const std::string& name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(id_, name.c_str()), x, y);
+    glUniform2f(Location(name), x, y);
 }
 
 void Shader::SetVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(id_, name.c_str()), 1, &value[0]);
+    glUniform3fv(Location(name), 1, &value[0]);
 }
 
 void Shader::SetVec3(const std::string& name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(id_, name.c_str()), x, y, z);
+    glUniform3f(Location(name), x, y, z);
 }
 
 void Shader::SetVec4(const std::string& name, const glm::vec4& value) const {
-    glUniform4fv(glGetUniformLocation(id_, name.c_str()), 1, &value[0]);
+    glUniform4fv(Location(name), 1, &value[0]);
 }
 
 void Shader::SetVec4(const std::string& name, float x, float y, float z, float w) {
-    glUniform4f(glGetUniformLocation(id_, name.c_str()), x, y, z, w);
+    glUniform4f(Location(name), x, y, z, w);
 }
 
 void Shader::SetMat2(const std::string& name, const glm::mat2& mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(Location(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(Location(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(Location(name), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::BindUniformBlock(const std::string& name, unsigned int binding) const {
+    GLuint index = glGetUniformBlockIndex(id_, name.c_str());
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(id_, index, binding);
+    }
+}
+
+int Shader::Location(const std::string& name) const {
+    auto it = locations_.find(name);
+    if (it != locations_.end()) {
+        return it->second;
+    }
+    std::lock_guard<std::mutex> lock(queried_mutex_);
+    auto queried = queried_locations_.find(name);
+    if (queried != queried_locations_.end()) {
+        return queried->second;
+    }
+    // -1 is cached as well, setting a uniform the compiler removed is a common no-op
+    int location = glGetUniformLocation(id_, name.c_str());
+    queried_locations_[name] = location;
+    return location;
 }
 
 void Shader::CheckCompileErrors(unsigned int shader, std::string type) {
@@ -146,3 +157,26 @@ void Shader::CheckCompileErrors(unsigned int shader, std::string type) {
         }
     }
 }
+
+void Shader::CacheUniformLocations() {
+    GLint uniform_num = 0;
+    glGetProgramiv(id_, GL_ACTIVE_UNIFORMS, &uniform_num);
+    for (GLint i = 0; i < uniform_num; i++) {
+        GLchar name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id_, static_cast<GLuint>(i), sizeof(name), &length, &size, &type, name);
+        GLint location = glGetUniformLocation(id_, name);
+        if (location < 0) {
+            continue;
+        }
+        std::string uniform_name(name, length);
+        locations_[uniform_name] = location;
+        // arrays are reported as "name[0]", also allow looking them up by "name"
+        if (uniform_name.size() > 3 &&
+            uniform_name.compare(uniform_name.size() - 3, 3, "[0]") == 0) {
+            locations_[uniform_name.substr(0, uniform_name.size() - 3)] = location;
+        }
+    }
+}
@@ -1,14 +1,19 @@
 #ifndef SRC_SHADER_H_
 #define SRC_SHADER_H_
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 
+#include "VirtualFileSystem.h"
+
 class Shader
 {
 public:
-    Shader(const char* vertex_path, const char* fragment_path, const char* geometry_path = nullptr);
+    Shader(const char* vertex_path, const char* fragment_path, const char* geometry_path = nullptr,
+        const VirtualFileSystem* vfs = nullptr);
     ~Shader() = default;
 
     void Use();
@@ -24,12 +29,21 @@ public:
     void SetMat2(const std::string& name, const glm::mat2& mat) const;
     void SetMat3(const std::string& name, const glm::mat3& mat) const;
     void SetMat4(const std::string& name, const glm::mat4& mat) const;
+    void BindUniformBlock(const std::string& name, unsigned int binding) const;
+    int Location(const std::string& name) const;
     inline unsigned int Id() const;
 
 private:
     void CheckCompileErrors(unsigned int shader, std::string type);
+    void CacheUniformLocations();
 
     unsigned int id_ = 0;
+    // filled once after linking and read-only afterwards, so lookups are safe from any thread
+    std::unordered_map<std::string, int> locations_ = {};
+    // names the active uniform list does not spell out, like "lights[1]", asked from GL on the
+    // first miss; misses stay rare, so the lock is only taken off the fast path
+    mutable std::unordered_map<std::string, int> queried_locations_ = {};
+    mutable std::mutex queried_mutex_;
 };
 
 unsigned int Shader::Id() const {
@@ -0,0 +1,117 @@
+#include "TextureArray.h"
+
+#include <iostream>
+
+#include <GL/glew.h>
+
+TextureArrayPool::~TextureArrayPool() {
+    for (ArrayBucket& bucket : arrays_) {
+        if (bucket.handle != 0) {
+            glMakeTextureHandleNonResidentARB(bucket.handle);
+        }
+        if (bucket.id != 0) {
+            glDeleteTextures(1, &bucket.id);
+        }
+    }
+}
+
+TextureSlot TextureArrayPool::Find(const std::string& path) const {
+    TextureSlot slot;
+    for (size_t i = 0; i < arrays_.size(); i++) {
+        for (size_t j = 0; j < arrays_[i].paths.size(); j++) {
+            if (arrays_[i].paths[j] == path) {
+                slot.array = static_cast<int>(i);
+                slot.layer = static_cast<int>(j);
+                return slot;
+            }
+        }
+    }
+    return slot;
+}
+
+TextureSlot TextureArrayPool::AddImage(const std::string& path, const unsigned char* data,
+    int width, int height, int component_num) {
+    TextureSlot slot = Find(path);
+    if (slot.layer >= 0) {
+        return slot;
+    }
+    if (component_num != 1 && component_num != 3 && component_num != 4) {
+        std::cout << "Wrong component number." << std::endl;
+        return slot;
+    }
+
+    // buckets already on the GPU are immutable, so new layers always go into a pending one
+    size_t index = 0;
+    for (; index < arrays_.size(); index++) {
+        const ArrayBucket& bucket = arrays_[index];
+        if (bucket.id == 0 && bucket.width == width && bucket.height == height &&
+            bucket.component_num == component_num && bucket.layer_num < MAX_LAYERS) {
+            break;
+        }
+    }
+    if (index == arrays_.size()) {
+        ArrayBucket bucket;
+        bucket.width = width;
+        bucket.height = height;
+        bucket.component_num = component_num;
+        arrays_.push_back(bucket);
+    }
+
+    ArrayBucket& bucket = arrays_[index];
+    size_t layer_size = static_cast<size_t>(width) * height * component_num;
+    bucket.pixels.insert(bucket.pixels.end(), data, data + layer_size);
+    bucket.paths.push_back(path);
+    slot.array = static_cast<int>(index);
+    slot.layer = bucket.layer_num++;
+    return slot;
+}
+
+void TextureArrayPool::Upload() {
+    bindless_ = GLEW_ARB_bindless_texture;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (ArrayBucket& bucket : arrays_) {
+        if (bucket.id != 0) {
+            continue;
+        }
+        GLenum format = GL_RGBA;
+        if (bucket.component_num == 1) {
+            format = GL_RED;
+        } else if (bucket.component_num == 3) {
+            format = GL_RGB;
+        }
+
+        glGenTextures(1, &bucket.id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, bucket.id);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, bucket.width, bucket.height,
+            bucket.layer_num, 0, format, GL_UNSIGNED_BYTE, bucket.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        if (bindless_) {
+            bucket.handle = glGetTextureHandleARB(bucket.id);
+            glMakeTextureHandleResidentARB(bucket.handle);
+        }
+        std::vector<unsigned char>().swap(bucket.pixels);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureArrayPool::Record(CommandBuffer& commands, int array, int location) const {
+    if (array < 0 || array >= static_cast<int>(arrays_.size())) {
+        return;
+    }
+    const ArrayBucket& bucket = arrays_[array];
+    if (bindless_) {
+        commands.Push(UniformHandleCommand{ location, bucket.handle });
+    } else {
+        commands.Push(BindTextureCommand{ TEXTURE_UNIT, TextureTarget::TEXTURE_2D_ARRAY,
+            bucket.id });
+        commands.Push(UniformIntCommand{ location, TEXTURE_UNIT });
+    }
+}
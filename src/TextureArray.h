@@ -0,0 +1,61 @@
+#ifndef SRC_TEXTUREARRAY_H_
+#define SRC_TEXTUREARRAY_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandBuffer.h"
+
+struct TextureSlot {
+    int array = -1;
+    int layer = -1;
+};
+
+// Packs same-sized images into GL_TEXTURE_2D_ARRAY textures so that meshes can select their
+// texture by layer index instead of rebinding per draw. When ARB_bindless_texture is available
+// each array is made resident and handed to the shader as a handle.
+class TextureArrayPool {
+public:
+    TextureArrayPool() = default;
+    // needs the context that uploaded the arrays to be current
+    ~TextureArrayPool();
+    TextureArrayPool(const TextureArrayPool&) = delete;
+    TextureArrayPool& operator=(const TextureArrayPool&) = delete;
+
+    TextureSlot Find(const std::string& path) const;
+    TextureSlot AddImage(const std::string& path, const unsigned char* data, int width,
+        int height, int component_num);
+    void Upload();
+    void Record(CommandBuffer& commands, int array, int location) const;
+    inline bool Bindless() const;
+    inline size_t ArrayNum() const;
+
+    static constexpr int TEXTURE_UNIT = 8;
+    static constexpr int MAX_LAYERS = 256;
+
+private:
+    struct ArrayBucket {
+        int width = 0;
+        int height = 0;
+        int component_num = 0;
+        int layer_num = 0;
+        unsigned int id = 0;
+        uint64_t handle = 0;
+        std::vector<std::string> paths = {};
+        std::vector<unsigned char> pixels = {};
+    };
+
+    std::vector<ArrayBucket> arrays_ = {};
+    bool bindless_ = false;
+};
+
+bool TextureArrayPool::Bindless() const {
+    return bindless_;
+}
+
+size_t TextureArrayPool::ArrayNum() const {
+    return arrays_.size();
+}
+
+#endif  // SRC_TEXTUREARRAY_H_
@@ -0,0 +1,118 @@
+#include "TransparencyPass.h"
+
+#include <iostream>
+
+#include <GL/glew.h>
+
+namespace {
+
+unsigned int CreateTarget(GLint internal_format, GLenum format, int width, int height) {
+    unsigned int texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+}  // namespace
+
+TransparencyPass::~TransparencyPass() {
+    Release();
+    if (empty_vao_ != 0) {
+        glDeleteVertexArrays(1, &empty_vao_);
+    }
+}
+
+bool TransparencyPass::Resize(const RenderTarget& scene_target) {
+    if (fbo_ != 0 && width_ == scene_target.Width() && height_ == scene_target.Height() &&
+        depth_buffer_ == scene_target.DepthBuffer()) {
+        return true;
+    }
+    Release();
+    if (empty_vao_ == 0) {
+        glGenVertexArrays(1, &empty_vao_);
+    }
+    width_ = scene_target.Width();
+    height_ = scene_target.Height();
+    depth_buffer_ = scene_target.DepthBuffer();
+
+    accumulation_texture_ = CreateTarget(GL_RGBA16F, GL_RGBA, width_, height_);
+    weight_texture_ = CreateTarget(GL_R16F, GL_RED, width_, height_);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+        accumulation_texture_, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weight_texture_,
+        0);
+    // opaque depth is tested but never written, so transparent surfaces hide behind walls only
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+        depth_buffer_);
+    const GLenum draw_buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, draw_buffers);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cout << "ERROR::TRANSPARENCY::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        Release();
+        return false;
+    }
+    return true;
+}
+
+void TransparencyPass::Begin(int width, int height) {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width, height);
+    const GLfloat clear_accumulation[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const GLfloat clear_weight[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clear_accumulation);
+    glClearBufferfv(GL_COLOR, 1, clear_weight);
+
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    // color and weight add up, alpha multiplies the revealage by (1 - alpha)
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void TransparencyPass::End() {
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void TransparencyPass::Composite(Shader& shader) const {
+    shader.Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, accumulation_texture_);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, weight_texture_);
+    glActiveTexture(GL_TEXTURE0);
+    shader.SetInt("accumulation", 0);
+    shader.SetInt("weight", 1);
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // one triangle covering the viewport, positions come from gl_VertexID
+    glBindVertexArray(empty_vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void TransparencyPass::Release() {
+    if (fbo_ == 0) {
+        return;
+    }
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteTextures(1, &accumulation_texture_);
+    glDeleteTextures(1, &weight_texture_);
+    fbo_ = 0;
+    accumulation_texture_ = 0;
+    weight_texture_ = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef SRC_TRANSPARENCYPASS_H_
+#define SRC_TRANSPARENCYPASS_H_
+
+#include "RenderTarget.h"
+#include "Shader.h"
+
+// Weighted blended order independent transparency (McGuire and Bavoil 2013). Transparent
+// surfaces are drawn in any order into two targets that share the scene depth buffer:
+//   accumulation (RGBA16F): rgb = sum of premultiplied color * weight, a = product of (1 - alpha)
+//   weight (R16F): sum of alpha * weight
+// Core 3.3 has no per-target blend functions, so the revealage product rides in the alpha of
+// the accumulation target, where a single glBlendFuncSeparate serves both targets. Composite
+// then resolves the weighted average over the opaque scene, independent of the layer count.
+class TransparencyPass {
+public:
+    TransparencyPass() = default;
+    ~TransparencyPass();
+    TransparencyPass(const TransparencyPass&) = delete;
+    TransparencyPass& operator=(const TransparencyPass&) = delete;
+
+    // follows the size and the depth buffer of the scene target
+    bool Resize(const RenderTarget& scene_target);
+    void Begin(int width, int height);
+    void End();
+    // draws over whatever framebuffer is bound, normally the scene target
+    void Composite(Shader& shader) const;
+
+private:
+    void Release();
+
+    unsigned int fbo_ = 0;
+    unsigned int accumulation_texture_ = 0;
+    unsigned int weight_texture_ = 0;
+    unsigned int empty_vao_ = 0;
+    unsigned int depth_buffer_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+#endif  // SRC_TRANSPARENCYPASS_H_
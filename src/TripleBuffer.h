@@ -0,0 +1,51 @@
+#ifndef SRC_TRIPLEBUFFER_H_
+#define SRC_TRIPLEBUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer. The producer always owns a back
+// slot it can fill without waiting, Publish() swaps it with the shared middle slot, and the
+// consumer picks up the newest published slot with Consume(). Stale frames are dropped.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    ~TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    T& WriteBuffer() {
+        return buffers_[back_];
+    }
+
+    void Publish() {
+        uint8_t old = middle_.exchange(static_cast<uint8_t>(back_ | DIRTY),
+            std::memory_order_acq_rel);
+        back_ = old & INDEX_MASK;
+    }
+
+    bool Consume() {
+        if ((middle_.load(std::memory_order_relaxed) & DIRTY) == 0) {
+            return false;
+        }
+        uint8_t old = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = old & INDEX_MASK;
+        return true;
+    }
+
+    const T& ReadBuffer() const {
+        return buffers_[front_];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY = 0x4;
+
+    T buffers_[3];
+    std::atomic<uint8_t> middle_{1};
+    uint8_t back_ = 0;
+    uint8_t front_ = 2;
+};
+
+#endif  // SRC_TRIPLEBUFFER_H_
@@ -0,0 +1,75 @@
+#include "VfsIOSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+VfsIOStream::VfsIOStream(FileView file) : file_(std::move(file)) {
+}
+
+size_t VfsIOStream::Read(void* buffer, size_t size, size_t count) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t available = (file_.Size() - position_) / size;
+    size_t read = std::min(count, available);
+    std::memcpy(buffer, file_.Data() + position_, read * size);
+    position_ += read * size;
+    return read;
+}
+
+size_t VfsIOStream::Write(const void* /*buffer*/, size_t /*size*/, size_t /*count*/) {
+    return 0;
+}
+
+aiReturn VfsIOStream::Seek(size_t offset, aiOrigin origin) {
+    size_t target = offset;
+    if (origin == aiOrigin_CUR) {
+        target = position_ + offset;
+    } else if (origin == aiOrigin_END) {
+        target = file_.Size() - offset;
+    }
+    if (target > file_.Size()) {
+        return aiReturn_FAILURE;
+    }
+    position_ = target;
+    return aiReturn_SUCCESS;
+}
+
+size_t VfsIOStream::Tell() const {
+    return position_;
+}
+
+size_t VfsIOStream::FileSize() const {
+    return file_.Size();
+}
+
+void VfsIOStream::Flush() {
+}
+
+VfsIOSystem::VfsIOSystem(const VirtualFileSystem& vfs) : vfs_(vfs) {
+}
+
+bool VfsIOSystem::Exists(const char* file) const {
+    return vfs_.Exists(file);
+}
+
+char VfsIOSystem::getOsSeparator() const {
+    return '/';
+}
+
+Assimp::IOStream* VfsIOSystem::Open(const char* file, const char* mode) {
+    // read only, writes are never served from a pack
+    if (std::strchr(mode, 'w') != nullptr || std::strchr(mode, 'a') != nullptr) {
+        return nullptr;
+    }
+    FileView view = vfs_.Open(file);
+    if (!view.Valid()) {
+        return nullptr;
+    }
+    return new VfsIOStream(std::move(view));
+}
+
+void VfsIOSystem::Close(Assimp::IOStream* stream) {
+    delete stream;
+}
@@ -0,0 +1,43 @@
+#ifndef SRC_VFSIOSYSTEM_H_
+#define SRC_VFSIOSYSTEM_H_
+
+#include <cstddef>
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include "VirtualFileSystem.h"
+
+// Lets Assimp read models and their side files through a VirtualFileSystem.
+class VfsIOStream : public Assimp::IOStream {
+public:
+    explicit VfsIOStream(FileView file);
+    ~VfsIOStream() override = default;
+
+    size_t Read(void* buffer, size_t size, size_t count) override;
+    size_t Write(const void* buffer, size_t size, size_t count) override;
+    aiReturn Seek(size_t offset, aiOrigin origin) override;
+    size_t Tell() const override;
+    size_t FileSize() const override;
+    void Flush() override;
+
+private:
+    FileView file_;
+    size_t position_ = 0;
+};
+
+class VfsIOSystem : public Assimp::IOSystem {
+public:
+    explicit VfsIOSystem(const VirtualFileSystem& vfs);
+    ~VfsIOSystem() override = default;
+
+    bool Exists(const char* file) const override;
+    char getOsSeparator() const override;
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override;
+    void Close(Assimp::IOStream* stream) override;
+
+private:
+    const VirtualFileSystem& vfs_;
+};
+
+#endif  // SRC_VFSIOSYSTEM_H_
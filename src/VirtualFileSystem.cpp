@@ -0,0 +1,353 @@
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef MOFU_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef MOFU_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "Path.h"
+
+namespace {
+
+constexpr char PACK_MAGIC[4] = { 'M', 'P', 'A', 'K' };
+constexpr size_t HEADER_SIZE = 24;
+constexpr size_t INDEX_ENTRY_SIZE = 32;
+
+// packs are written and read on little endian hosts only, which covers every supported target
+template <typename T>
+T ReadValue(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void WriteValue(std::vector<char>& out, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+bool Decompress(PackCompression compression, const char* source, size_t source_size,
+    char* target, size_t target_size) {
+    // unused when no codec is built in
+    (void)source;
+    (void)source_size;
+    (void)target;
+    (void)target_size;
+    switch (compression) {
+#ifdef MOFU_WITH_LZ4
+    case PackCompression::LZ4:
+        return LZ4_decompress_safe(source, target, static_cast<int>(source_size),
+            static_cast<int>(target_size)) == static_cast<int>(target_size);
+#endif
+#ifdef MOFU_WITH_ZSTD
+    case PackCompression::ZSTD:
+        return ZSTD_decompress(target, target_size, source, source_size) == target_size;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool CodecAvailable(PackCompression compression) {
+    switch (compression) {
+    case PackCompression::NONE:
+        return true;
+#ifdef MOFU_WITH_LZ4
+    case PackCompression::LZ4:
+        return true;
+#endif
+#ifdef MOFU_WITH_ZSTD
+    case PackCompression::ZSTD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// returns false when the codec is not built in or does not make the data smaller
+bool Compress(PackCompression compression, const char* source, size_t source_size,
+    std::vector<char>& target) {
+    (void)source;
+    (void)source_size;
+    (void)target;
+    switch (compression) {
+#ifdef MOFU_WITH_LZ4
+    case PackCompression::LZ4: {
+        target.resize(LZ4_compressBound(static_cast<int>(source_size)));
+        int size = LZ4_compress_default(source, target.data(), static_cast<int>(source_size),
+            static_cast<int>(target.size()));
+        target.resize(size > 0 ? size : 0);
+        return size > 0 && static_cast<size_t>(size) < source_size;
+    }
+#endif
+#ifdef MOFU_WITH_ZSTD
+    case PackCompression::ZSTD: {
+        target.resize(ZSTD_compressBound(source_size));
+        size_t size = ZSTD_compress(target.data(), target.size(), source, source_size, 19);
+        if (ZSTD_isError(size)) {
+            return false;
+        }
+        target.resize(size);
+        return size < source_size;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+// appends the files below root/directory, relative to root and sorted, so packs built from the
+// same tree are identical. Returns false when root/directory is not a directory.
+bool ListDirectory(const std::string& root, const std::string& directory,
+    std::vector<std::string>& files) {
+    std::vector<std::string> names;
+    std::vector<bool> is_directory;
+    std::string path = JoinPath(root, directory);
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        names.push_back(data.cFileName);
+        is_directory.push_back((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    while (dirent* entry = readdir(dir)) {
+        struct stat info;
+        std::string name = entry->d_name;
+        names.push_back(name);
+        is_directory.push_back(stat(JoinPath(path, name).c_str(), &info) == 0 &&
+            S_ISDIR(info.st_mode));
+    }
+    closedir(dir);
+#endif
+    std::vector<size_t> order(names.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&names](size_t a, size_t b) {
+        return names[a] < names[b];
+    });
+    for (size_t i : order) {
+        if (names[i] == "." || names[i] == "..") {
+            continue;
+        }
+        std::string relative = JoinPath(directory, names[i]);
+        if (is_directory[i]) {
+            ListDirectory(root, relative, files);
+        } else {
+            files.push_back(relative);
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+FileView::FileView(const char* data, size_t size, std::shared_ptr<const void> owner) :
+    data_(data), size_(size), owner_(std::move(owner)) {
+}
+
+bool VirtualFileSystem::MountPack(const std::string& pack_path, const std::string& mount_point) {
+    std::unique_ptr<MappedFile> pack(new MappedFile());
+    if (!pack->Open(pack_path)) {
+        return false;
+    }
+    const char* data = pack->Data();
+    size_t size = pack->Size();
+    if (size < HEADER_SIZE || std::memcmp(data, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+        ReadValue<uint32_t>(data + 4) != PACK_VERSION) {
+        std::cout << "ERROR::VFS::NOT_A_PACK " << pack_path << std::endl;
+        return false;
+    }
+    uint32_t entry_num = ReadValue<uint32_t>(data + 8);
+    uint64_t cursor = ReadValue<uint64_t>(data + 16);
+
+    std::unordered_map<std::string, PackEntry> entries;
+    for (uint32_t i = 0; i < entry_num; i++) {
+        if (cursor + INDEX_ENTRY_SIZE > size) {
+            std::cout << "ERROR::VFS::BROKEN_INDEX " << pack_path << std::endl;
+            return false;
+        }
+        const char* record = data + cursor;
+        PackEntry entry;
+        entry.pack = pack.get();
+        entry.offset = ReadValue<uint64_t>(record);
+        entry.stored_size = ReadValue<uint64_t>(record + 8);
+        entry.size = ReadValue<uint64_t>(record + 16);
+        entry.compression = static_cast<PackCompression>(ReadValue<uint32_t>(record + 24));
+        uint32_t name_length = ReadValue<uint32_t>(record + 28);
+        cursor += INDEX_ENTRY_SIZE;
+        if (cursor + name_length > size || entry.offset + entry.stored_size > size) {
+            std::cout << "ERROR::VFS::BROKEN_INDEX " << pack_path << std::endl;
+            return false;
+        }
+        std::string name(data + cursor, name_length);
+        cursor += name_length;
+        entries[NormalizePath(JoinPath(mount_point, name))] = entry;
+    }
+
+    // later mounts shadow earlier ones, which lets a patch pack override single files
+    for (std::pair<const std::string, PackEntry>& entry : entries) {
+        entries_[entry.first] = entry.second;
+    }
+    packs_.push_back(std::move(pack));
+    return true;
+}
+
+FileView VirtualFileSystem::Open(const std::string& path) const {
+    std::string key = NormalizePath(path);
+    auto found = entries_.find(key);
+    if (found != entries_.end()) {
+        const PackEntry& entry = found->second;
+        const char* stored = entry.pack->Data() + entry.offset;
+        if (entry.compression == PackCompression::NONE) {
+            return FileView(stored, static_cast<size_t>(entry.size));
+        }
+        std::shared_ptr<std::vector<char>> buffer(
+            new std::vector<char>(static_cast<size_t>(entry.size)));
+        if (!Decompress(entry.compression, stored, static_cast<size_t>(entry.stored_size),
+            buffer->data(), buffer->size())) {
+            std::cout << "ERROR::VFS::DECOMPRESS_FAILED " << path << std::endl;
+            return FileView();
+        }
+        return FileView(buffer->data(), buffer->size(), buffer);
+    }
+
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    if (!file->Open(key)) {
+        return FileView();
+    }
+    if (file->Size() == 0) {
+        return FileView("", 0);
+    }
+    return FileView(file->Data(), file->Size(), file);
+}
+
+bool VirtualFileSystem::Exists(const std::string& path) const {
+    std::string key = NormalizePath(path);
+    if (entries_.count(key) != 0) {
+        return true;
+    }
+    std::ifstream file(key, std::ios::binary);
+    return file.good();
+}
+
+bool VirtualFileSystem::BuildPack(const std::string& pack_path, const std::string& root,
+    const std::vector<std::string>& files, PackCompression compression) {
+    std::ofstream out(pack_path, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR::VFS::CANNOT_WRITE " << pack_path << std::endl;
+        return false;
+    }
+    if (!CodecAvailable(compression)) {
+        std::cout << "WARNING::VFS::CODEC_NOT_BUILT_IN storing entries uncompressed" << std::endl;
+        compression = PackCompression::NONE;
+    }
+    std::vector<char> header(HEADER_SIZE, 0);
+    out.write(header.data(), header.size());
+
+    std::vector<char> index;
+    std::vector<char> compressed;
+    uint64_t offset = HEADER_SIZE;
+    uint32_t entry_num = 0;
+    for (const std::string& name : files) {
+        MappedFile file;
+        if (!file.Open(JoinPath(root, name))) {
+            return false;
+        }
+        const char* stored = file.Data();
+        uint64_t stored_size = file.Size();
+        PackCompression entry_compression = PackCompression::NONE;
+        if (compression != PackCompression::NONE && file.Size() > 0 &&
+            Compress(compression, file.Data(), file.Size(), compressed)) {
+            stored = compressed.data();
+            stored_size = compressed.size();
+            entry_compression = compression;
+        }
+
+        uint64_t padding = (PACK_ALIGNMENT - offset % PACK_ALIGNMENT) % PACK_ALIGNMENT;
+        std::vector<char> zeros(static_cast<size_t>(padding), 0);
+        out.write(zeros.data(), zeros.size());
+        offset += padding;
+        if (stored_size > 0) {
+            out.write(stored, static_cast<std::streamsize>(stored_size));
+        }
+
+        std::string entry_name = NormalizePath(name);
+        WriteValue<uint64_t>(index, offset);
+        WriteValue<uint64_t>(index, stored_size);
+        WriteValue<uint64_t>(index, file.Size());
+        WriteValue<uint32_t>(index, static_cast<uint32_t>(entry_compression));
+        WriteValue<uint32_t>(index, static_cast<uint32_t>(entry_name.size()));
+        index.insert(index.end(), entry_name.begin(), entry_name.end());
+        offset += stored_size;
+        entry_num++;
+    }
+    out.write(index.data(), index.size());
+
+    header.clear();
+    header.insert(header.end(), PACK_MAGIC, PACK_MAGIC + sizeof(PACK_MAGIC));
+    WriteValue<uint32_t>(header, PACK_VERSION);
+    WriteValue<uint32_t>(header, entry_num);
+    WriteValue<uint32_t>(header, 0);
+    WriteValue<uint64_t>(header, offset);
+    out.seekp(0);
+    out.write(header.data(), header.size());
+    return static_cast<bool>(out);
+}
+
+bool VirtualFileSystem::BuildPackFromList(const std::string& pack_path, const std::string& root,
+    const std::string& list_path, PackCompression compression) {
+    MappedFile list;
+    if (!list.Open(list_path)) {
+        return false;
+    }
+    std::vector<std::string> files;
+    const char* cursor = list.Data();
+    const char* end = cursor + list.Size();
+    while (cursor < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        std::string line(cursor, line_end);
+        cursor = line_end + 1;
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#' && !ListDirectory(root, line, files)) {
+            files.push_back(line);
+        }
+    }
+    if (!BuildPack(pack_path, root, files, compression)) {
+        return false;
+    }
+    std::cout << "Packed " << files.size() << " files into " << pack_path << std::endl;
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef SRC_VIRTUALFILESYSTEM_H_
+#define SRC_VIRTUALFILESYSTEM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Read-only view of a file's bytes. Stored pack entries point straight into the pack mapping,
+// decompressed entries and loose files keep their own storage alive through owner_.
+class FileView {
+public:
+    FileView() = default;
+    FileView(const char* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+    ~FileView() = default;
+
+    inline const char* Data() const;
+    inline size_t Size() const;
+    inline bool Valid() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::shared_ptr<const void> owner_ = nullptr;
+};
+
+enum class PackCompression : uint32_t {
+    NONE,
+    LZ4,
+    ZSTD
+};
+
+// Resolves asset paths against mounted pack files first and the disk second. A pack is mapped
+// once when mounted; its entries are then served without any further syscalls or copies. Pack
+// layout, all integers little endian:
+//   header: "MPAK", uint32 version, uint32 entry count, uint32 reserved, uint64 index offset
+//   entry data, each blob 16 byte aligned
+//   index: per entry uint64 offset, uint64 stored size, uint64 size, uint32 compression,
+//          uint32 name length, name bytes
+// Entry names are paths relative to the mount point. LZ4 and zstd entries are only readable
+// when built with MOFU_WITH_LZ4 / MOFU_WITH_ZSTD.
+class VirtualFileSystem {
+public:
+    VirtualFileSystem() = default;
+    ~VirtualFileSystem() = default;
+
+    bool MountPack(const std::string& pack_path, const std::string& mount_point);
+    FileView Open(const std::string& path) const;
+    bool Exists(const std::string& path) const;
+    inline size_t PackEntryNum() const;
+
+    static bool BuildPack(const std::string& pack_path, const std::string& root,
+        const std::vector<std::string>& files, PackCompression compression);
+    // list file: one path relative to root per line, '#' starts a comment line. A directory
+    // adds every file below it.
+    static bool BuildPackFromList(const std::string& pack_path, const std::string& root,
+        const std::string& list_path, PackCompression compression);
+
+    static constexpr uint32_t PACK_VERSION = 1;
+    static constexpr size_t PACK_ALIGNMENT = 16;
+
+private:
+    struct PackEntry {
+        const MappedFile* pack = nullptr;
+        uint64_t offset = 0;
+        uint64_t stored_size = 0;
+        uint64_t size = 0;
+        PackCompression compression = PackCompression::NONE;
+    };
+
+    std::vector<std::unique_ptr<MappedFile>> packs_ = {};
+    std::unordered_map<std::string, PackEntry> entries_ = {};
+};
+
+const char* FileView::Data() const {
+    return data_;
+}
+
+size_t FileView::Size() const {
+    return size_;
+}
+
+bool FileView::Valid() const {
+    return data_ != nullptr;
+}
+
+size_t VirtualFileSystem::PackEntryNum() const {
+    return entries_.size();
+}
+
+#endif  // SRC_VIRTUALFILESYSTEM_H_
@@ -0,0 +1,25 @@
+#include "World.h"
+
+Entity World::CreateEntity() {
+    if (!free_indices_.empty()) {
+        uint32_t index = free_indices_.back();
+        free_indices_.pop_back();
+        return Entity{ index, generations_[index] };
+    }
+    generations_.push_back(0);
+    return Entity{ static_cast<uint32_t>(generations_.size() - 1), 0 };
+}
+
+void World::DestroyEntity(Entity entity) {
+    // a second destroy would put the index on the free list twice and hand it out to two
+    // entities, and a stale handle would destroy whoever holds the index now
+    if (!Alive(entity)) {
+        return;
+    }
+    transforms_.Remove(entity);
+    mesh_renderers_.Remove(entity);
+    bounds_.Remove(entity);
+    lights_.Remove(entity);
+    generations_[entity.index]++;
+    free_indices_.push_back(entity.index);
+}
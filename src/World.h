@@ -0,0 +1,204 @@
+#ifndef SRC_WORLD_H_
+#define SRC_WORLD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Components.h"
+
+// Slot index plus the generation the slot had when the handle was made. Destroying an entity
+// bumps the generation of its slot, so a kept handle no longer matches once the slot is reused.
+struct Entity {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
+inline bool operator==(Entity a, Entity b);
+inline bool operator!=(Entity a, Entity b);
+
+// Sparse set storage: components sit packed in one array in insertion order and the sparse array
+// maps an entity to its slot, so systems iterate contiguous memory and lookups stay O(1).
+// Removal swaps the last component into the hole.
+template <typename T>
+class ComponentPool {
+public:
+    ComponentPool() = default;
+    ~ComponentPool() = default;
+
+    T& Add(Entity entity, const T& component);
+    void Remove(Entity entity);
+    inline bool Has(Entity entity) const;
+    inline T& Get(Entity entity);
+    inline const T& Get(Entity entity) const;
+    inline size_t Size() const;
+    inline T* Data();
+    inline const T* Data() const;
+    inline const Entity* Entities() const;
+    // slot of the entity in Data() and Entities(), only meaningful while Has(entity)
+    inline size_t IndexOf(Entity entity) const;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    std::vector<uint32_t> sparse_ = {};
+    std::vector<Entity> entities_ = {};
+    std::vector<T> components_ = {};
+};
+
+class World {
+public:
+    World() = default;
+    ~World() = default;
+
+    Entity CreateEntity();
+    // stale or already destroyed handles are ignored
+    void DestroyEntity(Entity entity);
+    inline bool Alive(Entity entity) const;
+    inline size_t EntityNum() const;
+
+    inline ComponentPool<Transform>& Transforms();
+    inline const ComponentPool<Transform>& Transforms() const;
+    inline ComponentPool<MeshRenderer>& MeshRenderers();
+    inline const ComponentPool<MeshRenderer>& MeshRenderers() const;
+    inline ComponentPool<Bounds>& BoundsPool();
+    inline const ComponentPool<Bounds>& BoundsPool() const;
+    inline ComponentPool<LightComponent>& Lights();
+    inline const ComponentPool<LightComponent>& Lights() const;
+
+private:
+    std::vector<uint32_t> generations_ = {};
+    std::vector<uint32_t> free_indices_ = {};
+    ComponentPool<Transform> transforms_;
+    ComponentPool<MeshRenderer> mesh_renderers_;
+    ComponentPool<Bounds> bounds_;
+    ComponentPool<LightComponent> lights_;
+};
+
+bool operator==(Entity a, Entity b) {
+    return a.index == b.index && a.generation == b.generation;
+}
+
+bool operator!=(Entity a, Entity b) {
+    return !(a == b);
+}
+
+template <typename T>
+constexpr uint32_t ComponentPool<T>::NONE;
+
+template <typename T>
+T& ComponentPool<T>::Add(Entity entity, const T& component) {
+    if (entity.index >= sparse_.size()) {
+        sparse_.resize(entity.index + 1, NONE);
+    }
+    uint32_t slot = sparse_[entity.index];
+    if (slot != NONE) {
+        // a component left behind by an older generation of the index is taken over
+        entities_[slot] = entity;
+        components_[slot] = component;
+        return components_[slot];
+    }
+    sparse_[entity.index] = static_cast<uint32_t>(components_.size());
+    entities_.push_back(entity);
+    components_.push_back(component);
+    return components_.back();
+}
+
+template <typename T>
+void ComponentPool<T>::Remove(Entity entity) {
+    if (!Has(entity)) {
+        return;
+    }
+    uint32_t slot = sparse_[entity.index];
+    Entity last = entities_.back();
+    components_[slot] = components_.back();
+    entities_[slot] = last;
+    sparse_[last.index] = slot;
+    components_.pop_back();
+    entities_.pop_back();
+    sparse_[entity.index] = NONE;
+}
+
+template <typename T>
+bool ComponentPool<T>::Has(Entity entity) const {
+    return entity.index < sparse_.size() && sparse_[entity.index] != NONE &&
+        entities_[sparse_[entity.index]].generation == entity.generation;
+}
+
+template <typename T>
+T& ComponentPool<T>::Get(Entity entity) {
+    return components_[sparse_[entity.index]];
+}
+
+template <typename T>
+const T& ComponentPool<T>::Get(Entity entity) const {
+    return components_[sparse_[entity.index]];
+}
+
+template <typename T>
+size_t ComponentPool<T>::Size() const {
+    return components_.size();
+}
+
+template <typename T>
+T* ComponentPool<T>::Data() {
+    return components_.data();
+}
+
+template <typename T>
+const T* ComponentPool<T>::Data() const {
+    return components_.data();
+}
+
+template <typename T>
+const Entity* ComponentPool<T>::Entities() const {
+    return entities_.data();
+}
+
+template <typename T>
+size_t ComponentPool<T>::IndexOf(Entity entity) const {
+    return sparse_[entity.index];
+}
+
+bool World::Alive(Entity entity) const {
+    return entity.index < generations_.size() &&
+        generations_[entity.index] == entity.generation;
+}
+
+size_t World::EntityNum() const {
+    return generations_.size() - free_indices_.size();
+}
+
+ComponentPool<Transform>& World::Transforms() {
+    return transforms_;
+}
+
+const ComponentPool<Transform>& World::Transforms() const {
+    return transforms_;
+}
+
+ComponentPool<MeshRenderer>& World::MeshRenderers() {
+    return mesh_renderers_;
+}
+
+const ComponentPool<MeshRenderer>& World::MeshRenderers() const {
+    return mesh_renderers_;
+}
+
+ComponentPool<Bounds>& World::BoundsPool() {
+    return bounds_;
+}
+
+const ComponentPool<Bounds>& World::BoundsPool() const {
+    return bounds_;
+}
+
+ComponentPool<LightComponent>& World::Lights() {
+    return lights_;
+}
+
+const ComponentPool<LightComponent>& World::Lights() const {
+    return lights_;
+}
+
+#endif  // SRC_WORLD_H_
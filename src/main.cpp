@@ -1,7 +1,67 @@
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+
 #include "MofuWindow.h"
+#include "Path.h"
+#include "VirtualFileSystem.h"
 
 int main(int argc, char* argv[]) {
 	MofuWindow window = {};
+	std::string resource_root = "../../../..";
+	std::string build_pack_path;
+	PackCompression compression = PackCompression::NONE;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--threaded-render") == 0) {
+			window.SetThreadedRender(true);
+		} else if (std::strcmp(argv[i], "--no-vsync") == 0) {
+			window.SetVsync(false);
+		} else if (std::strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc) {
+			window.SetMaxFps(std::atof(argv[++i]));
+		} else if (std::strcmp(argv[i], "--depth-prepass") == 0) {
+			window.SetDepthPrepass(true);
+		} else if (std::strcmp(argv[i], "--no-sort") == 0) {
+			window.SetSortFrontToBack(false);
+		} else if (std::strcmp(argv[i], "--no-occlusion-culling") == 0) {
+			window.SetOcclusionCulling(false);
+		} else if (std::strcmp(argv[i], "--no-texture-array") == 0) {
+			window.SetUseTextureArray(false);
+		} else if (std::strcmp(argv[i], "--no-shadows") == 0) {
+			window.SetShadows(false);
+		} else if (std::strcmp(argv[i], "--shadow-budget") == 0 && i + 1 < argc) {
+			window.SetShadowBudget(std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+			window.SetDemoInstances(std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+			resource_root = argv[++i];
+			window.SetResourceRoot(resource_root);
+		} else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+			window.SetScenePath(argv[++i]);
+		} else if (std::strcmp(argv[i], "--stream-data-budget-kb") == 0 && i + 1 < argc) {
+			window.SetStreamingDataBudget(static_cast<size_t>(std::atoi(argv[++i])) * 1024);
+		} else if (std::strcmp(argv[i], "--target-frame-ms") == 0 && i + 1 < argc) {
+			window.SetTargetFrameTime(std::atof(argv[++i]));
+		} else if (std::strcmp(argv[i], "--min-render-scale") == 0 && i + 1 < argc) {
+			window.SetMinResolutionScale(static_cast<float>(std::atof(argv[++i])));
+		} else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+			window.AddPack(argv[++i]);
+		} else if (std::strcmp(argv[i], "--build-pack") == 0 && i + 1 < argc) {
+			build_pack_path = argv[++i];
+		} else if (std::strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+			i++;
+			if (std::strcmp(argv[i], "lz4") == 0) {
+				compression = PackCompression::LZ4;
+			} else if (std::strcmp(argv[i], "zstd") == 0) {
+				compression = PackCompression::ZSTD;
+			}
+		}
+	}
+	if (!build_pack_path.empty()) {
+		bool built = VirtualFileSystem::BuildPackFromList(build_pack_path, resource_root,
+			JoinPath(resource_root, "pack.list"), compression);
+		return built ? 0 : 1;
+	}
 	window.ShowWindow();
 	return 0;
 }